@@ -0,0 +1,156 @@
+// latency of the plugin entry points (codeEditor_open, setText, getText, show,
+// close) called from a fake simulation thread, i.e. including the SIM->UI hop
+// through the blocking queued connections of SIM.cpp/UI.cpp, while the UI
+// thread is kept busy by a synthetic paint load.
+//
+//   QT_QPA_PLATFORM=offscreen ./simCodeEditorApiBench --paint-load 4 --output report.json
+
+#include "harness.h"
+#include "common.h"
+#include "stubs.h"
+#include <simPlusPlus/Plugin.h>
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QPainter>
+#include <QSemaphore>
+#include <QThread>
+#include <QTimer>
+#include <QWidget>
+
+SIM_DLLEXPORT int codeEditor_open(const char *initText, const char *properties);
+SIM_DLLEXPORT int codeEditor_setText(int handle, const char *text, int insertMode);
+SIM_DLLEXPORT char * codeEditor_getText(int handle, int *positionAndSize);
+SIM_DLLEXPORT int codeEditor_show(int handle, int showState);
+SIM_DLLEXPORT int codeEditor_close(int handle, int *positionAndSize);
+
+// a window whose every paint keeps the UI thread busy for the given time
+class PaintLoad : public QWidget
+{
+public:
+    PaintLoad(int costUs) : costUs(costUs)
+    {
+        resize(640, 480);
+    }
+
+protected:
+    void paintEvent(QPaintEvent *event)
+    {
+        QPainter p(this);
+        QElapsedTimer t;
+        t.start();
+        for(int i = 0; t.nsecsElapsed() < costUs * 1000LL; i++)
+            p.drawText((i * 37) % width(), (i * 17) % height(), QStringLiteral("paint load"));
+    }
+
+private:
+    int costUs;
+};
+
+int main(int argc, char **argv)
+{
+    if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Latency of the plugin entry points called from the simulation thread");
+    parser.addHelpOption();
+    parser.addOption({"iterations", "Open/setText/getText/show/close cycles.", "n", "200"});
+    parser.addOption({"calls", "setText/getText/show calls per cycle.", "n", "20"});
+    parser.addOption({"lines", "Lines of code passed to open/setText.", "n", "1000"});
+    parser.addOption({"paint-load", "Time spent in each synthetic paint on the UI thread, in ms (0 = none).", "ms", "4"});
+    parser.addOption({"paint-fps", "Synthetic paints per second.", "n", "60"});
+    parser.addOption({"resources", "Directory containing the snippets directory.", "dir", BENCHMARK_RESOURCES_DIR});
+    parser.addOption({"corpus", "Directory generated by simCodeEditorCorpusGen.", "dir", BENCHMARK_CORPUS_DIR});
+    parser.addOption({"output", "JSON report file, or - for stdout.", "file", "-"});
+    parser.process(app);
+
+    int iterations = parser.value("iterations").toInt();
+    int calls = parser.value("calls").toInt();
+    int lines = parser.value("lines").toInt();
+    double paintLoadMs = parser.value("paint-load").toDouble();
+    int paintFps = parser.value("paint-fps").toInt();
+
+    QByteArray text = corpusScript(parser.value("corpus"), "lua", lines).toUtf8();
+    if(text.isEmpty())
+    {
+        for(int i = 0; i < lines; i++)
+            text += "print('line " + QByteArray::number(i) + "')\n";
+    }
+    QByteArray properties = corpusProperties(parser.value("corpus"), "lua").toUtf8();
+    if(properties.isEmpty())
+        properties = "<editor lang='lua'/>";
+
+    BenchmarkReport report;
+    report.setInfo("qt", qVersion());
+    report.setInfo("platform", QGuiApplication::platformName());
+    report.setInfo("iterations", iterations);
+    report.setInfo("calls", calls);
+    report.setInfo("lines", lines);
+    report.setInfo("paintLoadMs", paintLoadMs);
+    report.setInfo("paintFps", paintFps);
+
+    // the plugin is initialized as in CoppeliaSim: onInit on the SIM
+    // thread (which owns the SIM object), then onUIInit on the UI thread
+    QSemaphore initialized, uiInitialized;
+    QThread *simThreadObj = QThread::create([&] {
+        benchmarkPluginInit();
+        EditorOptions::resourcesPath = parser.value("resources");
+        initialized.release();
+        uiInitialized.acquire();
+
+        QElapsedTimer wall;
+        wall.start();
+        auto timed = [&] (const char *name, auto f) {
+            QElapsedTimer t;
+            t.start();
+            auto ret = f();
+            report.add(name, t.nsecsElapsed());
+            return ret;
+        };
+        for(int i = 0; i < iterations; i++)
+        {
+            int handle = timed("open", [&] { return codeEditor_open(text.constData(), properties.constData()); });
+            for(int j = 0; j < calls; j++)
+            {
+                timed("setText", [&] { return codeEditor_setText(handle, text.constData(), 0); });
+                char *s = timed("getText", [&] { return codeEditor_getText(handle, nullptr); });
+                sim::releaseBuffer(s);
+                timed("show", [&] { return codeEditor_show(handle, j % 2); });
+            }
+            int posAndSize[4];
+            timed("close", [&] { return codeEditor_close(handle, posAndSize); });
+        }
+        report.setInfo("wallSeconds", wall.nsecsElapsed() / 1e9);
+
+        QMetaObject::invokeMethod(qApp, "quit", Qt::QueuedConnection);
+    });
+    simThreadObj->start();
+    initialized.acquire();
+    benchmarkPluginUIInit();
+    uiInitialized.release();
+
+    PaintLoad paintLoad(int(paintLoadMs * 1000));
+    QTimer paintTimer;
+    if(paintLoadMs > 0 && paintFps > 0)
+    {
+        paintLoad.show();
+        QObject::connect(&paintTimer, &QTimer::timeout, &paintLoad, QOverload<>::of(&QWidget::update));
+        paintTimer.start(1000 / paintFps);
+    }
+
+    app.exec();
+
+    simThreadObj->wait();
+    delete simThreadObj;
+    benchmarkPluginUICleanup();
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    benchmarkPluginCleanup();
+
+    if(!report.write(parser.value("output")))
+    {
+        qWarning("cannot write %s", qPrintable(parser.value("output")));
+        return 1;
+    }
+    return 0;
+}
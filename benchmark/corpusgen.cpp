@@ -0,0 +1,377 @@
+// generates a reproducible corpus for the benchmarks:
+//
+//   <output>/lua/script-<lines>.lua, <output>/python/script-<lines>.py
+//       scripts made of the constructs getFunctionDefs recognizes, sysCall_*
+//       callbacks as in the bundled snippets, long strings and comments
+//   <output>/properties-lua.xml, <output>/properties-python.xml
+//       editor properties with N keywords (with calltips)
+//   <output>/snippets/<lang>/group_<g>/...
+//       snippet trees with N files, in the layout SnippetsLibrary loads
+//   <output>/manifest.json
+//       list of the generated files
+//
+// only the standard library is used, and the output depends only on the
+// arguments (the random generator is seeded and used without distributions).
+
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct Options
+{
+    std::vector<int> lines {1000, 10000, 100000};
+    int keywords {500};
+    int snippets {100};
+    unsigned seed {1};
+    fs::path output {"corpus"};
+};
+
+class Generator
+{
+public:
+    Generator(unsigned seed) : rng_(seed) {}
+
+    int pick(int n) { return int(rng_() % std::uint32_t(n)); }
+
+    std::string ident(const char *prefix)
+    {
+        static const char *words[] = {"robot", "joint", "sensor", "path", "target", "gripper", "camera", "force", "pose", "shape"};
+        return std::string(prefix) + words[pick(10)] + std::to_string(counter_++);
+    }
+
+private:
+    std::mt19937 rng_;
+    int counter_ {0};
+};
+
+using Lines = std::vector<std::string>;
+
+static const char *luaSysCalls[] = {"sysCall_init", "sysCall_actuation", "sysCall_sensing", "sysCall_cleanup", "sysCall_nonSimulation", "sysCall_beforeSimulation", "sysCall_afterSimulation"};
+static const char *pythonSysCalls[] = {"sysCall_init", "sysCall_actuation", "sysCall_sensing", "sysCall_cleanup"};
+
+static Lines luaBlock(Generator &g)
+{
+    Lines l;
+    std::string f = g.ident("");
+    switch(g.pick(7))
+    {
+    case 0: // function f(args)
+        l.push_back("function " + f + "(handle, name)");
+        l.push_back("    local h = sim.getObject('/" + f + "')");
+        l.push_back("    if handle == nil then");
+        l.push_back("        return h");
+        l.push_back("    end");
+        l.push_back("    return sim.getObjectPosition(h, handle), name");
+        l.push_back("end");
+        break;
+    case 1: // f = function(args)
+        l.push_back(f + " = function(a, b)");
+        l.push_back("    local s = 0");
+        l.push_back("    for i = a, b do s = s + i * i end");
+        l.push_back("    return s");
+        l.push_back("end");
+        break;
+    case 2: // function obj.f(args), function obj:f(args)
+        l.push_back("local " + f + " = {}");
+        l.push_back("function " + f + ".new(x, y)");
+        l.push_back("    return setmetatable({x = x, y = y}, {__index = " + f + "})");
+        l.push_back("end");
+        l.push_back("function " + f + ":length()");
+        l.push_back("    return math.sqrt(self.x * self.x + self.y * self.y)");
+        l.push_back("end");
+        break;
+    case 3: // long string
+        l.push_back("local " + f + " = [[");
+        for(int i = 0, n = 3 + g.pick(10); i < n; i++)
+            l.push_back("    long string line " + std::to_string(i) + " with 'quotes' and \"double quotes\" -- not a comment");
+        l.push_back("]]");
+        break;
+    case 4: // long comment
+        l.push_back("--[[");
+        for(int i = 0, n = 3 + g.pick(10); i < n; i++)
+            l.push_back("    commented out: function " + f + "_" + std::to_string(i) + "() return nil end");
+        l.push_back("]]");
+        break;
+    case 5: // line comments and a table
+        l.push_back("-- " + f + ": configuration table");
+        l.push_back("-- (values are in meters and radians)");
+        l.push_back(f + " = {");
+        for(int i = 0, n = 2 + g.pick(8); i < n; i++)
+            l.push_back("    key" + std::to_string(i) + " = " + std::to_string(g.pick(1000)) + ".5,");
+        l.push_back("}");
+        break;
+    default: // local function with control flow
+        l.push_back("local function " + f + "(t)");
+        l.push_back("    for k, v in pairs(t) do");
+        l.push_back("        if type(v) == 'table' then");
+        l.push_back("            " + f + "(v)");
+        l.push_back("        elseif v ~= nil then");
+        l.push_back("            print(k, v)");
+        l.push_back("        end");
+        l.push_back("    end");
+        l.push_back("end");
+        break;
+    }
+    l.push_back("");
+    return l;
+}
+
+static Lines pythonBlock(Generator &g)
+{
+    Lines l;
+    std::string f = g.ident("");
+    switch(g.pick(6))
+    {
+    case 0: // def f(args):
+        l.push_back("def " + f + "(handle, name=None):");
+        l.push_back("    h = sim.getObject('/" + f + "')");
+        l.push_back("    if handle is None:");
+        l.push_back("        return h");
+        l.push_back("    return sim.getObjectPosition(h, handle), name");
+        break;
+    case 1: // class with methods
+        l.push_back("class " + f + ":");
+        l.push_back("    def __init__(self, x, y):");
+        l.push_back("        self.x = x");
+        l.push_back("        self.y = y");
+        l.push_back("");
+        l.push_back("    def length(self):");
+        l.push_back("        return math.sqrt(self.x * self.x + self.y * self.y)");
+        break;
+    case 2: // triple-quoted string
+        l.push_back(f + " = \"\"\"");
+        for(int i = 0, n = 3 + g.pick(10); i < n; i++)
+            l.push_back("    long string line " + std::to_string(i) + " with 'quotes' and # not a comment");
+        l.push_back("\"\"\"");
+        break;
+    case 3: // comments
+        for(int i = 0, n = 2 + g.pick(6); i < n; i++)
+            l.push_back("# " + f + ": comment line " + std::to_string(i) + ", def " + f + "_" + std::to_string(i) + "(): not a definition");
+        break;
+    case 4: // dict
+        l.push_back(f + " = {");
+        for(int i = 0, n = 2 + g.pick(8); i < n; i++)
+            l.push_back("    'key" + std::to_string(i) + "': " + std::to_string(g.pick(1000)) + ".5,");
+        l.push_back("}");
+        break;
+    default: // def with control flow
+        l.push_back("def " + f + "(t):");
+        l.push_back("    for k, v in t.items():");
+        l.push_back("        if isinstance(v, dict):");
+        l.push_back("            " + f + "(v)");
+        l.push_back("        elif v is not None:");
+        l.push_back("            print(k, v)");
+        break;
+    }
+    l.push_back("");
+    l.push_back("");
+    return l;
+}
+
+static Lines script(Generator &g, bool python, int lines)
+{
+    Lines out;
+    auto append = [&] (const Lines &block) {
+        out.insert(out.end(), block.begin(), block.end());
+    };
+    const char *comment = python ? "#" : "--";
+    out.push_back(std::string(comment) + " generated by simCodeEditorCorpusGen (" + std::to_string(lines) + " lines)");
+    if(python)
+        out.push_back("import math");
+    out.push_back("");
+
+    // callbacks, as in the bundled snippets:
+    int n = python ? int(std::size(pythonSysCalls)) : int(std::size(luaSysCalls));
+    for(int i = 0; i < n; i++)
+    {
+        Lines l;
+        if(python)
+        {
+            l.push_back(std::string("def ") + pythonSysCalls[i] + "():");
+            l.push_back("    # put your code here");
+            l.push_back("    pass");
+            l.push_back("");
+        }
+        else
+        {
+            l.push_back(std::string("function ") + luaSysCalls[i] + "()");
+            l.push_back("    -- put your code here");
+            l.push_back("end");
+        }
+        l.push_back("");
+        if(out.size() + l.size() <= size_t(lines))
+            append(l);
+    }
+
+    // only whole blocks, so that the result stays syntactically valid:
+    while(true)
+    {
+        Lines l = python ? pythonBlock(g) : luaBlock(g);
+        if(out.size() + l.size() > size_t(lines)) break;
+        append(l);
+    }
+    while(out.size() < size_t(lines))
+        out.push_back(std::string(comment) + " padding");
+    out.resize(lines);
+    return out;
+}
+
+static std::string xmlEscape(const std::string &s)
+{
+    std::string ret;
+    for(char c : s)
+    {
+        switch(c)
+        {
+        case '<': ret += "&lt;"; break;
+        case '>': ret += "&gt;"; break;
+        case '&': ret += "&amp;"; break;
+        case '"': ret += "&quot;"; break;
+        default: ret += c;
+        }
+    }
+    return ret;
+}
+
+static std::string properties(Generator &g, bool python, int keywords)
+{
+    std::ostringstream s;
+    s << "<editor lang=\"" << (python ? "python" : "lua") << "\" toolbar=\"true\" statusbar=\"true\" searchable=\"true\" line-numbers=\"true\" size=\"800 600\">\n";
+    for(int k = 1; k <= 2; k++)
+    {
+        s << "    <keywords" << k << ">\n";
+        for(int i = k - 1; i < keywords; i += 2)
+        {
+            std::string word = (k == 1 ? "bench.function" : "bench.constant") + std::to_string(i);
+            std::string calltip = k == 1
+                ? "int result=" + word + "(int handle,string name,float[3] position)"
+                : "int " + word;
+            s << "        <item word=\"" << xmlEscape(word) << "\" autocomplete=\"" << (g.pick(4) ? "true" : "false") << "\" calltip=\"" << xmlEscape(calltip) << "\"/>\n";
+        }
+        s << "    </keywords" << k << ">\n";
+    }
+    s << "</editor>\n";
+    return s.str();
+}
+
+static bool writeFile(const fs::path &path, const std::string &content, std::vector<fs::path> &written)
+{
+    fs::create_directories(path.parent_path());
+    std::ofstream f(path, std::ios::binary);
+    f << content;
+    if(!f)
+    {
+        std::cerr << "cannot write " << path.string() << std::endl;
+        return false;
+    }
+    written.push_back(path);
+    return true;
+}
+
+static std::string join(const Lines &lines)
+{
+    std::string ret;
+    for(const auto &l : lines)
+        ret += l + "\n";
+    return ret;
+}
+
+static bool generate(const Options &opts)
+{
+    std::vector<fs::path> written;
+    for(bool python : {false, true})
+    {
+        const std::string lang = python ? "python" : "lua";
+        const std::string ext = python ? "py" : "lua";
+        const std::string comment = python ? "#" : "--";
+
+        // each output gets its own generator, so that changing one option
+        // doesn't change the other files:
+        for(int n : opts.lines)
+        {
+            Generator g(opts.seed + n);
+            if(!writeFile(opts.output / lang / ("script-" + std::to_string(n) + "." + ext), join(script(g, python, n)), written))
+                return false;
+        }
+
+        Generator gp(opts.seed);
+        if(!writeFile(opts.output / ("properties-" + lang + ".xml"), properties(gp, python, opts.keywords), written))
+            return false;
+
+        Generator gs(opts.seed);
+        for(int i = 0; i < opts.snippets; i++)
+        {
+            fs::path group = opts.output / "snippets" / lang / ("group_" + std::to_string(i / 10));
+            if(i % 10 == 0)
+            {
+                if(!writeFile(group / ("__index__." + ext), comment + " @name Group " + std::to_string(i / 10) + "\n", written))
+                    return false;
+            }
+            Lines body = python ? pythonBlock(gs) : luaBlock(gs);
+            body.insert(body.begin(), comment + " @name Snippet " + std::to_string(i));
+            if(!writeFile(group / ("snippet_" + std::to_string(i) + "." + ext), join(body), written))
+                return false;
+        }
+    }
+
+    std::ostringstream manifest;
+    manifest << "{\n    \"seed\": " << opts.seed << ",\n    \"files\": [\n";
+    for(size_t i = 0; i < written.size(); i++)
+        manifest << "        \"" << fs::relative(written[i], opts.output).generic_string() << "\"" << (i + 1 < written.size() ? "," : "") << "\n";
+    manifest << "    ]\n}\n";
+    return writeFile(opts.output / "manifest.json", manifest.str(), written);
+}
+
+static void usage(const char *argv0)
+{
+    std::cerr << "usage: " << argv0 << " [--lines n1,n2,...] [--keywords n] [--snippets n] [--seed n] [--output dir]" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    Options opts;
+    for(int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if(arg == "--help" || arg == "-h")
+        {
+            usage(argv[0]);
+            return 0;
+        }
+        if(i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        if(arg == "--lines")
+        {
+            opts.lines.clear();
+            std::istringstream s(value);
+            for(std::string n; std::getline(s, n, ',');)
+                opts.lines.push_back(std::atoi(n.c_str()));
+        }
+        else if(arg == "--keywords")
+            opts.keywords = std::atoi(value.c_str());
+        else if(arg == "--snippets")
+            opts.snippets = std::atoi(value.c_str());
+        else if(arg == "--seed")
+            opts.seed = unsigned(std::strtoul(value.c_str(), nullptr, 10));
+        else if(arg == "--output")
+            opts.output = value;
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    return generate(opts) ? 0 : 1;
+}
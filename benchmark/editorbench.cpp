@@ -0,0 +1,269 @@
+// offscreen benchmark of the editor widgets (Dialog, Editor, ToolBar,
+// SnippetsLibrary), linked against a stub simPlusPlus: no CoppeliaSim needed.
+//
+//   QT_QPA_PLATFORM=offscreen ./simCodeEditorBench --output report.json
+
+#include "harness.h"
+#include "SIM.h"
+#include "UI.h"
+#include "dialog.h"
+#include "editor.h"
+#include "finder.h"
+#include "fuzzymatch.h"
+#include "stubs.h"
+#include <QApplication>
+#include <QClipboard>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QThread>
+
+static QString generateLua(int lines)
+{
+    QString code;
+    QTextStream s(&code);
+    int n = 0;
+    while(n < lines)
+    {
+        int i = n / 10;
+        s << "-- helper number " << i << "\n";
+        s << "function helper" << i << "(a, b)\n";
+        s << "    local s = 'some string value ' .. a\n";
+        s << "    for j = 1, b do\n";
+        s << "        s = s .. tostring(j)\n";
+        s << "    end\n";
+        s << "    return s, sim.getObject('/robot" << i << "')\n";
+        s << "end\n";
+        s << "\n";
+        s << "\n";
+        n += 10;
+    }
+    return code;
+}
+
+static QString properties = "<editor lang='lua' toolbar='true' statusbar='true' searchable='true' line-numbers='true' size='800 600'/>";
+static QString corpusDir;
+
+static Dialog * openDialog(UI *ui, const QString &text)
+{
+    // same steps as UI::createWindow:
+    EditorOptions o;
+    o.readFromXML(properties);
+    o.snippetsPaths << EditorOptions::resourcesPath + "/snippets";
+    if(!corpusDir.isEmpty())
+        o.snippetsPaths << corpusDir + "/snippets";
+    Dialog *dialog = new Dialog(o, ui, nullptr);
+    dialog->setEditorOptions(o);
+    dialog->setInitText(text);
+    dialog->show();
+    flushEvents(dialog);
+    return dialog;
+}
+
+static void benchTyping(BenchmarkReport &report, UI *ui, const QString &text, int iterations)
+{
+    Dialog *dialog = openDialog(ui, text);
+    Editor *editor = dialog->activeEditor();
+    editor->setFocus();
+    editor->setCursorPosition(editor->lines() / 2, 0);
+    const QString typed("local x = sim.getObject('/a')\n");
+    for(int i = 0; i < iterations; i++)
+    {
+        QChar c = typed.at(i % typed.size());
+        int key = c == '\n' ? Qt::Key_Return : c.toUpper().unicode();
+        report.measure("typing", [&] {
+            QKeyEvent press(QEvent::KeyPress, key, Qt::NoModifier, c == '\n' ? QString() : QString(c));
+            QCoreApplication::sendEvent(editor, &press);
+            QKeyEvent release(QEvent::KeyRelease, key, Qt::NoModifier, c == '\n' ? QString() : QString(c));
+            QCoreApplication::sendEvent(editor, &release);
+            flushEvents(editor->viewport());
+        });
+    }
+    delete dialog;
+}
+
+static void benchScrolling(BenchmarkReport &report, UI *ui, const QString &text, int iterations)
+{
+    Dialog *dialog = openDialog(ui, text);
+    Editor *editor = dialog->activeEditor();
+    int direction = 1;
+    for(int i = 0; i < iterations; i++)
+    {
+        int first = editor->SendScintilla(QsciScintillaBase::SCI_GETFIRSTVISIBLELINE);
+        if(first + 60 >= editor->lines()) direction = -1;
+        else if(first == 0) direction = 1;
+        report.measure("scrolling", [&] {
+            editor->SendScintilla(QsciScintillaBase::SCI_LINESCROLL, 0ul, long(direction * 20));
+            flushEvents(editor->viewport());
+        });
+    }
+    delete dialog;
+}
+
+static void benchPaste(BenchmarkReport &report, UI *ui, const QString &text, int iterations)
+{
+    Dialog *dialog = openDialog(ui, text);
+    Editor *editor = dialog->activeEditor();
+    QApplication::clipboard()->setText(generateLua(50));
+    editor->setCursorPosition(editor->lines() / 2, 0);
+    for(int i = 0; i < iterations; i++)
+    {
+        report.measure("paste", [&] {
+            editor->paste();
+            flushEvents(editor->viewport());
+        });
+    }
+    delete dialog;
+}
+
+static void benchFind(BenchmarkReport &report, UI *ui, const QString &text, int iterations)
+{
+    Dialog *dialog = openDialog(ui, text);
+    Editor *editor = dialog->activeEditor();
+    editor->setCursorPosition(0, 0);
+    SearchOptions word;
+    word.what = "tostring";
+    word.caseSensitive = true;
+    for(int i = 0; i < iterations; i++)
+    {
+        report.measure("find", [&] {
+            editor->findMatch(word, true);
+            flushEvents(editor->viewport());
+        });
+    }
+
+    SearchOptions opts;
+    opts.what = "sim\\.getObject\\('/robot\\d+'\\)";
+    opts.regExp = true;
+    opts.caseSensitive = true;
+    std::atomic<bool> cancel {false};
+    for(int i = 0; i < qMax(1, iterations / 20); i++)
+    {
+        report.measure("findAll", [&] {
+            findAll(editor->utf8Text(), opts, cancel, [] (const QVector<SearchMatch> &) {});
+        });
+    }
+    delete dialog;
+}
+
+static void benchWindows(BenchmarkReport &report, UI *ui, const QString &text, int windows)
+{
+    QVector<Dialog*> dialogs;
+    for(int i = 0; i < windows; i++)
+        report.measure("openWindow", [&] { dialogs << openDialog(ui, text); });
+    for(Dialog *dialog : dialogs)
+    {
+        report.measure("closeWindow", [&] {
+            delete dialog;
+            flushEvents();
+        });
+    }
+}
+
+static void benchPalette(BenchmarkReport &report, int candidates, int iterations)
+{
+    // names like those of the Ctrl+P palette (functions, snippets, files):
+    FuzzyIndex index;
+    report.measure("paletteIndex", [&] {
+        index.reserve(candidates, 40 * candidates);
+        for(int i = 0; i < candidates; i++)
+        {
+            if(i % 10 == 0)
+                index.add(QStringLiteral("/home/user/scripts/module%1/robot%2.lua").arg(i % 97).arg(i));
+            else
+                index.add(QStringLiteral("module%1.helper%2(a, b)").arg(i % 97).arg(i));
+        }
+    });
+
+    // queries typed one character at a time, from unselective to selective:
+    const QStringList queries {"helper123", "mod5h", "robotlua", "zq"};
+    for(int i = 0; i < qMax(1, iterations / 10); i++)
+    {
+        const QString &query = queries.at(i % queries.size());
+        for(int n = 1; n <= query.size(); n++)
+            report.measure("paletteMatch", [&] { index.match(query.left(n), 100); });
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Offscreen benchmark of the code editor widgets");
+    parser.addHelpOption();
+    parser.addOption({"lines", "Lines of code in each editor.", "n", "10000"});
+    parser.addOption({"iterations", "Iterations of each scenario.", "n", "200"});
+    parser.addOption({"windows", "Windows to open in the windows scenario.", "n", "50"});
+    parser.addOption({"candidates", "Candidates of the fuzzy matching in the palette scenario.", "n", "50000"});
+    parser.addOption({"scenario", "Scenario to run (typing, scrolling, paste, find, windows, palette); can be repeated, default: all.", "name"});
+    parser.addOption({"resources", "Directory containing the snippets directory.", "dir", BENCHMARK_RESOURCES_DIR});
+    parser.addOption({"corpus", "Directory generated by simCodeEditorCorpusGen; empty to use built-in text.", "dir", BENCHMARK_CORPUS_DIR});
+    parser.addOption({"output", "JSON report file, or - for stdout.", "file", "-"});
+    parser.process(app);
+
+    EditorOptions::resourcesPath = parser.value("resources");
+    int lines = parser.value("lines").toInt();
+    int iterations = parser.value("iterations").toInt();
+    int windows = parser.value("windows").toInt();
+    int candidates = parser.value("candidates").toInt();
+    QStringList scenarios = parser.values("scenario");
+    if(scenarios.isEmpty())
+        scenarios << "typing" << "scrolling" << "paste" << "find" << "windows" << "palette";
+
+    // same thread layout as in CoppeliaSim, with an idle SIM thread:
+    uiThread();
+    QThread simThreadObj;
+    SIM sim;
+    sim.moveToThread(&simThreadObj);
+    simThreadObj.start();
+    QMetaObject::invokeMethod(&sim, [] { simThread(); }, Qt::BlockingQueuedConnection);
+    UI ui(&sim);
+
+    BenchmarkReport report;
+    report.setInfo("qt", qVersion());
+    report.setInfo("platform", QGuiApplication::platformName());
+    report.setInfo("lines", lines);
+    report.setInfo("iterations", iterations);
+    report.setInfo("candidates", candidates);
+
+    // use the generated corpus when it has a script of the requested size:
+    QString text = corpusScript(parser.value("corpus"), "lua", lines);
+    if(!text.isNull())
+    {
+        corpusDir = parser.value("corpus");
+        QString p = corpusProperties(corpusDir, "lua");
+        if(!p.isNull()) properties = p;
+    }
+    else
+        text = generateLua(lines);
+    report.setInfo("corpus", corpusDir);
+    for(const QString &scenario : scenarios)
+    {
+        if(scenario == "typing")
+            benchTyping(report, &ui, text, iterations);
+        else if(scenario == "scrolling")
+            benchScrolling(report, &ui, text, iterations);
+        else if(scenario == "paste")
+            benchPaste(report, &ui, text, iterations);
+        else if(scenario == "find")
+            benchFind(report, &ui, text, iterations);
+        else if(scenario == "windows")
+            benchWindows(report, &ui, text, windows);
+        else if(scenario == "palette")
+            benchPalette(report, candidates, iterations);
+        else
+            qWarning("unknown scenario: %s", qPrintable(scenario));
+    }
+
+    simThreadObj.quit();
+    simThreadObj.wait();
+
+    if(!report.write(parser.value("output")))
+    {
+        qWarning("cannot write %s", qPrintable(parser.value("output")));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include "harness.h"
+#include "stats.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QWidget>
+#include <algorithm>
+
+void BenchmarkReport::add(const QString &name, qint64 ns)
+{
+    samples_[name].append(ns);
+}
+
+void BenchmarkReport::setInfo(const QString &key, const QJsonValue &value)
+{
+    info_[key] = value;
+}
+
+QJsonObject BenchmarkReport::toJson() const
+{
+    QJsonObject scenarios;
+    for(auto it = samples_.constBegin(); it != samples_.constEnd(); ++it)
+    {
+        QVector<qint64> v = it.value();
+        std::sort(v.begin(), v.end());
+        qint64 total = 0;
+        for(qint64 ns : v) total += ns;
+        auto percentileUs = [&] (double p) {
+            return v[qMin(v.size() - 1, int(p * v.size()))] / 1e3;
+        };
+        QJsonObject o;
+        o["count"] = v.size();
+        o["totalMs"] = total / 1e6;
+        o["meanUs"] = total / 1e3 / v.size();
+        o["p50Us"] = percentileUs(0.50);
+        o["p90Us"] = percentileUs(0.90);
+        o["p99Us"] = percentileUs(0.99);
+        o["maxUs"] = v.last() / 1e3;
+        o["perSecond"] = total ? v.size() * 1e9 / total : 0.;
+        scenarios[it.key()] = o;
+    }
+
+    QJsonObject ret;
+    ret["info"] = info_;
+    ret["scenarios"] = scenarios;
+    // the plugin's own instrumentation, accumulated over the whole run:
+    ret["counters"] = QJsonDocument::fromJson(statsToJson().toUtf8()).object();
+    return ret;
+}
+
+bool BenchmarkReport::write(const QString &path) const
+{
+    QByteArray json = QJsonDocument(toJson()).toJson(QJsonDocument::Indented);
+    if(path == "-")
+    {
+        QTextStream(stdout) << json;
+        return true;
+    }
+    QFile f(path);
+    if(!f.open(QIODevice::WriteOnly)) return false;
+    return f.write(json) == json.size();
+}
+
+static QString readCorpusFile(const QString &path)
+{
+    QFile f(path);
+    if(!f.open(QIODevice::ReadOnly)) return {};
+    return QString::fromUtf8(f.readAll());
+}
+
+QString corpusScript(const QString &corpusDir, const QString &lang, int lines)
+{
+    return readCorpusFile(QStringLiteral("%1/%2/script-%3.%4").arg(corpusDir, lang).arg(lines).arg(lang == "python" ? "py" : "lua"));
+}
+
+QString corpusProperties(const QString &corpusDir, const QString &lang)
+{
+    return readCorpusFile(QStringLiteral("%1/properties-%2.xml").arg(corpusDir, lang));
+}
+
+void flushEvents(QWidget *paintWidget)
+{
+    QCoreApplication::sendPostedEvents();
+    QCoreApplication::processEvents();
+    if(paintWidget)
+        paintWidget->repaint();
+}
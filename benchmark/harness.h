@@ -0,0 +1,44 @@
+#ifndef HARNESS_H
+#define HARNESS_H
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+class QWidget;
+
+// collects timing samples per scenario and reports them as JSON
+class BenchmarkReport
+{
+public:
+    void add(const QString &name, qint64 ns);
+    void setInfo(const QString &key, const QJsonValue &value);
+
+    template<typename F>
+    void measure(const QString &name, F f)
+    {
+        QElapsedTimer t;
+        t.start();
+        f();
+        add(name, t.nsecsElapsed());
+    }
+
+    QJsonObject toJson() const;
+    // path "-" writes to stdout
+    bool write(const QString &path) const;
+
+private:
+    QMap<QString, QVector<qint64>> samples_;
+    QJsonObject info_;
+};
+
+// files generated by simCodeEditorCorpusGen (null string if not generated)
+QString corpusScript(const QString &corpusDir, const QString &lang, int lines);
+QString corpusProperties(const QString &corpusDir, const QString &lang);
+
+// deliver pending events, then paint the widget synchronously
+void flushEvents(QWidget *paintWidget = nullptr);
+
+#endif // HARNESS_H
@@ -0,0 +1,9 @@
+#ifndef PLUGIN_H_INCLUDED
+#define PLUGIN_H_INCLUDED
+
+// stand-in for the plugin.h generated from callbacks.xml
+
+#define PLUGIN_NAME "CodeEditor"
+#define PLUGIN_VERSION 1
+
+#endif // PLUGIN_H_INCLUDED
@@ -0,0 +1,109 @@
+#include <simPlusPlus/Plugin.h>
+#include "stubs.h"
+#include <QtGlobal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+Qt::HANDLE UI_THREAD = nullptr;
+Qt::HANDLE SIM_THREAD = nullptr;
+
+void uiThread()
+{
+    UI_THREAD = QThread::currentThreadId();
+}
+
+void simThread()
+{
+    SIM_THREAD = QThread::currentThreadId();
+}
+
+void assertThread(const char *id, const char *file, int line)
+{
+    bool negate = id[0] == '!';
+    Qt::HANDLE expected = strcmp(id + negate, "UI") == 0 ? UI_THREAD : SIM_THREAD;
+    if(!expected) return;
+    if((QThread::currentThreadId() == expected) == negate)
+        qFatal("%s:%d: ASSERT_THREAD(%s) failed", file, line, id);
+}
+
+bool registerScriptStuff()
+{
+    return true;
+}
+
+static int simulationState = sim_simulation_stopped;
+
+namespace sim
+{
+    void addLogMessage(int verbosity, const std::string &msg)
+    {
+        if(verbosity <= sim_verbosity_warnings)
+            fprintf(stderr, "%s\n", msg.c_str());
+    }
+
+    void * getMainWindow(int type)
+    {
+        // dialogs become top-level windows
+        return nullptr;
+    }
+
+    char * createBuffer(int size)
+    {
+        return static_cast<char *>(malloc(size));
+    }
+
+    void releaseBuffer(const void *buffer)
+    {
+        free(const_cast<void *>(buffer));
+    }
+
+    void eventNotification(const std::string &event)
+    {
+    }
+
+    int createStack()
+    {
+        return 1;
+    }
+
+    void releaseStack(int stackHandle)
+    {
+    }
+
+    int getScriptHandleEx(int scriptType)
+    {
+        return -1;
+    }
+
+    void executeScriptString(int scriptHandle, const std::string &code, int stackHandle)
+    {
+    }
+
+    int getSimulationState()
+    {
+        return simulationState;
+    }
+
+    void setSimulationState(int state)
+    {
+        simulationState = state;
+    }
+
+    int getIntProperty(int target, const std::string &name)
+    {
+        // not headless; odd version: development build, no online lookup
+        if(name == "productVersionNb") return 1;
+        return 0;
+    }
+
+    std::string getStringProperty(int target, const std::string &name)
+    {
+        return {};
+    }
+
+    std::optional<bool> getBoolProperty(int target, const std::string &name, std::optional<bool> defaultValue)
+    {
+        return defaultValue;
+    }
+}
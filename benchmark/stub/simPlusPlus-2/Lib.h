@@ -0,0 +1 @@
+#include "../simPlusPlus/Lib.h"
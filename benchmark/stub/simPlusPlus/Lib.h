@@ -0,0 +1,45 @@
+#ifndef SIMPLUSPLUS_LIB_H_INCLUDED
+#define SIMPLUSPLUS_LIB_H_INCLUDED
+
+// minimal stand-in for simPlusPlus' Lib.h, used by the benchmarks:
+// provides only what the editor sources call, without needing CoppeliaSim
+
+#include <string>
+
+#define sim_verbosity_none 0
+#define sim_verbosity_errors 100
+#define sim_verbosity_warnings 200
+#define sim_verbosity_loadinfos 300
+#define sim_verbosity_infos 500
+#define sim_verbosity_debug 600
+
+#define sim_scripttype_sandbox 8
+#define sim_simulation_stopped 0x00
+#define sim_simulation_advancing_running 0x11
+
+namespace sim
+{
+    void addLogMessage(int verbosity, const std::string &msg);
+
+    template<typename... Arguments>
+    void addLog(int verbosity, const std::string &fmt, Arguments&&... args)
+    {
+        // arguments are not formatted, the stub only records the message
+        addLogMessage(verbosity, fmt);
+    }
+
+    void * getMainWindow(int type);
+    char * createBuffer(int size);
+    void releaseBuffer(const void *buffer);
+    void eventNotification(const std::string &event);
+    int createStack();
+    void releaseStack(int stackHandle);
+    int getScriptHandleEx(int scriptType);
+    void executeScriptString(int scriptHandle, const std::string &code, int stackHandle);
+    int getSimulationState();
+
+    // not part of simPlusPlus: lets a benchmark flip the simulation state
+    void setSimulationState(int state);
+}
+
+#endif // SIMPLUSPLUS_LIB_H_INCLUDED
@@ -0,0 +1,52 @@
+#ifndef SIMPLUSPLUS_PLUGIN_H_INCLUDED
+#define SIMPLUSPLUS_PLUGIN_H_INCLUDED
+
+// minimal stand-in for simPlusPlus' Plugin.h, used by the benchmarks: instead
+// of the simInit/simCleanup/simMsg exports, SIM_UI_PLUGIN defines hooks that
+// the benchmark calls from its fake SIM thread and from the UI thread
+
+#include "Lib.h"
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#define SIM_DLLEXPORT extern "C"
+
+#define sim_handle_app -2
+
+namespace sim
+{
+    int getIntProperty(int target, const std::string &name);
+    std::string getStringProperty(int target, const std::string &name);
+    std::optional<bool> getBoolProperty(int target, const std::string &name, std::optional<bool> defaultValue);
+
+    class Plugin
+    {
+    public:
+        virtual ~Plugin() {}
+        virtual void onInit() {}
+        virtual void onCleanup() {}
+        virtual void onUIInit() {}
+        virtual void onUICleanup() {}
+        virtual void onSimulationAboutToStart() {}
+        virtual void onSimulationEnded() {}
+
+        void setExtVersion(const std::string &s) {}
+        void setBuildDate(const std::string &s) {}
+    };
+}
+
+// called by the benchmark, each on the same thread as in CoppeliaSim:
+void benchmarkPluginInit();      // SIM thread
+void benchmarkPluginUIInit();    // UI thread
+void benchmarkPluginUICleanup(); // UI thread
+void benchmarkPluginCleanup();   // SIM thread
+
+#define SIM_UI_PLUGIN(className) \
+    namespace sim { ::className *plugin = nullptr; } \
+    void benchmarkPluginInit() { sim::plugin = new ::className; sim::plugin->onInit(); } \
+    void benchmarkPluginUIInit() { sim::plugin->onUIInit(); } \
+    void benchmarkPluginUICleanup() { sim::plugin->onUICleanup(); } \
+    void benchmarkPluginCleanup() { sim::plugin->onCleanup(); delete sim::plugin; sim::plugin = nullptr; }
+
+#endif // SIMPLUSPLUS_PLUGIN_H_INCLUDED
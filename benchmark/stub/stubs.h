@@ -0,0 +1,42 @@
+#ifndef STUBS_H__INCLUDED
+#define STUBS_H__INCLUDED
+
+// stand-in for the stubs generated from callbacks.xml: thread checks and
+// the types of the script functions used by plugin.cpp
+
+#include <QThread>
+#include <string>
+
+extern Qt::HANDLE UI_THREAD;
+extern Qt::HANDLE SIM_THREAD;
+
+void uiThread();
+void simThread();
+// id is one of "UI", "!UI", "SIM", "!SIM"
+void assertThread(const char *id, const char *file, int line);
+
+#define ASSERT_THREAD(ID) assertThread(#ID, __FILE__, __LINE__)
+
+bool registerScriptStuff();
+
+struct getStats_in
+{
+    bool reset {false};
+};
+
+struct getStats_out
+{
+    std::string stats;
+};
+
+struct getMemoryUsage_in
+{
+    int handle {-1};
+};
+
+struct getMemoryUsage_out
+{
+    std::string usage;
+};
+
+#endif // STUBS_H__INCLUDED
@@ -24,6 +24,7 @@ signals:
     void show(int handle, int showState);
     void close(int handle, int *positionAndSize);
     void simulationRunning(bool running);
+    void getMemoryUsage(int handle, QString *json);
 };
 
 #endif // SIM_H__INCLUDED
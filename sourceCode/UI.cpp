@@ -2,7 +2,10 @@
 #include "SIM.h"
 #include "dialog.h"
 #include "common.h"
+#include "symbolindex.h"
+#include "stats.h"
 #include <QDebug>
+#include <QJsonDocument>
 #include <simPlusPlus-2/Lib.h>
 #include "stubs.h"
 
@@ -17,6 +20,7 @@ UI::UI(SIM *sim)
     QObject::connect(sim, &SIM::show, ui, &UI::show, sim2ui);
     QObject::connect(sim, &SIM::close, ui, &UI::close, sim2ui);
     QObject::connect(sim, &SIM::simulationRunning, ui, &UI::onSimulationRunning, sim2ui);
+    QObject::connect(sim, &SIM::getMemoryUsage, ui, &UI::getMemoryUsage, sim2ui);
     Qt::ConnectionType ui2sim = Qt::AutoConnection;
     QObject::connect(ui, &UI::notifyEvent, sim, &SIM::notifyEvent, ui2sim);
     QObject::connect(ui, &UI::openURL, sim, &SIM::openURL, ui2sim);
@@ -31,6 +35,8 @@ Dialog * UI::createWindow(bool modalSpecial, const QString &initText, const QStr
     o.readFromXML(properties);
     o.modalSpecial = modalSpecial;
     o.snippetsPaths << EditorOptions::resourcesPath + "/snippets";
+    if(!o.scriptSearchPath.isEmpty())
+        SymbolIndex::instance()->update(o.scriptSearchPath);
 
     QWidget *parent = (QWidget *)sim::getMainWindow(1);
     Dialog *window = new Dialog(o, this, parent);
@@ -44,6 +50,7 @@ Dialog * UI::createWindow(bool modalSpecial, const QString &initText, const QStr
 void UI::openModal(const QString &initText, const QString &properties, QString& text, int *positionAndSize)
 {
     ASSERT_THREAD(UI);
+    STATS_SCOPE("UI::openModal");
 
     Dialog *editor = createWindow(true, initText, properties);
     text = editor->makeModal(positionAndSize).c_str();
@@ -52,6 +59,7 @@ void UI::openModal(const QString &initText, const QString &properties, QString&
 void UI::open(const QString &initText, const QString &properties, int *handle)
 {
     ASSERT_THREAD(UI);
+    STATS_SCOPE("UI::open");
     Dialog *editor = createWindow(false, initText, properties);
     *handle = nextEditorHandle++;
     editor->setHandle(*handle);
@@ -61,6 +69,7 @@ void UI::open(const QString &initText, const QString &properties, int *handle)
 void UI::setText(int handle, const QString &text, int insertMode)
 {
     ASSERT_THREAD(UI);
+    STATS_SCOPE("UI::setText");
 
     Dialog *editor = editors.value(handle);
     if(editor)
@@ -70,6 +79,7 @@ void UI::setText(int handle, const QString &text, int insertMode)
 void UI::getText(int handle, QString *text, int* posAndSize)
 {
     ASSERT_THREAD(UI);
+    STATS_SCOPE("UI::getText");
 
     Dialog *editor = editors.value(handle);
     if(editor)
@@ -88,6 +98,7 @@ void UI::getText(int handle, QString *text, int* posAndSize)
 void UI::show(int handle, int showState)
 {
     ASSERT_THREAD(UI);
+    STATS_SCOPE("UI::show");
 
     Dialog *editor = editors.value(handle);
     if(editor)
@@ -102,6 +113,7 @@ void UI::show(int handle, int showState)
 void UI::close(int handle, int *positionAndSize)
 {
     ASSERT_THREAD(UI);
+    STATS_SCOPE("UI::close");
 
     Dialog *editor = editors.value(handle);
     if(editor)
@@ -125,3 +137,26 @@ void UI::onSimulationRunning(bool running)
         editor->onSimulationRunning(running);
     }
 }
+
+void UI::getMemoryUsage(int handle, QString *json)
+{
+    ASSERT_THREAD(UI);
+    STATS_SCOPE("UI::getMemoryUsage");
+
+    // handle -1 reports all the editors:
+    MemoryUsage total;
+    QJsonObject editorsUsage;
+    for(auto it = editors.constBegin(); it != editors.constEnd(); ++it)
+    {
+        if(handle != -1 && it.key() != handle) continue;
+        MemoryUsage u = it.value()->memoryUsage();
+        total += u;
+        QJsonObject o = u.toJson();
+        o["title"] = it.value()->windowTitle();
+        editorsUsage[QString::number(it.key())] = o;
+    }
+    QJsonObject ret;
+    ret["total"] = total.toJson();
+    ret["editors"] = editorsUsage;
+    *json = QString::fromUtf8(QJsonDocument(ret).toJson(QJsonDocument::Compact));
+}
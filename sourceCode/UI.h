@@ -26,6 +26,7 @@ public:
     void show(int handle, int showState);
     void close(int handle, int *positionAndSize);
     void onSimulationRunning(bool running);
+    void getMemoryUsage(int handle, QString *json);
 
 signals:
     void notifyEvent(int handle, const QString &eventType, const QString &data);
@@ -0,0 +1,17 @@
+#include "analysis.h"
+#include "editor.h"
+
+QThreadPool * analysisPool()
+{
+    static QThreadPool *pool = [] {
+        auto p = new QThreadPool;
+        p->setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+        return p;
+    }();
+    return pool;
+}
+
+bool isCurrentRevision(const QPointer<Editor> &editor, quint64 revision)
+{
+    return editor && editor->revision() == revision;
+}
@@ -0,0 +1,41 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QPointer>
+#include <QThreadPool>
+#include <functional>
+
+class Editor;
+
+// immutable copy of the text of a document (UTF-8), tagged with the
+// revision of the editor at the time it was taken
+struct DocumentSnapshot
+{
+    QByteArray text;
+    quint64 revision {0};
+};
+
+// bounded thread pool for the analyses of document snapshots (outline,
+// find all, ...), leaving one core for the UI and simulation threads
+QThreadPool * analysisPool();
+
+// true if the editor still exists and is still at the given revision
+bool isCurrentRevision(const QPointer<Editor> &editor, quint64 revision);
+
+// run job on a snapshot in the analysis pool; onResult is called on the UI
+// thread with the result, but only if the editor hasn't changed meanwhile
+template<typename Result>
+void runAnalysis(Editor *editor, const DocumentSnapshot &snapshot, const std::function<Result(const DocumentSnapshot &)> &job, const std::function<void(const Result &)> &onResult)
+{
+    QPointer<Editor> target(editor);
+    analysisPool()->start([=] {
+        Result result = job(snapshot);
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [=] {
+            if(isCurrentRevision(target, snapshot.revision)) onResult(result);
+        }, Qt::QueuedConnection);
+    });
+}
+
+#endif // ANALYSIS_H
@@ -0,0 +1,158 @@
+#include "changetracker.h"
+#include <QHash>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// beyond this number of edits (in the part between the common head and
+// tail) the diff gives up, and reports the whole part as changed
+const int maxEdits = 1000;
+
+struct Edit
+{
+    bool insert;    // else delete
+    int x, y;       // position in base and current before the edit
+};
+
+// shortest edit script from a to b (Myers' O(ND) algorithm); false if it
+// has more than maxEdits edits
+bool editScript(const size_t *a, int n, const size_t *b, int m, QVector<Edit> &script)
+{
+    const int max = std::min(n + m, maxEdits);
+    const int offset = max + 1;
+    std::vector<int> v(2 * max + 3, 0);
+    // v after each round d, for k in [-d, d], starting at d * d:
+    std::vector<int> trace;
+
+    int d = 0;
+    for(; d <= max; d++)
+    {
+        bool done = false;
+        for(int k = -d; k <= d; k += 2)
+        {
+            int x = k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1])
+                ? v[offset + k + 1]
+                : v[offset + k - 1] + 1;
+            int y = x - k;
+            while(x < n && y < m && a[x] == b[y]) x++, y++;
+            v[offset + k] = x;
+            if(x >= n && y >= m) done = true;
+        }
+        trace.insert(trace.end(), v.begin() + offset - d, v.begin() + offset + d + 1);
+        if(done) break;
+    }
+    if(d > max) return false;
+
+    // walk back from the end:
+    int x = n, y = m;
+    for(; d > 0; d--)
+    {
+        const int *prev = trace.data() + (d - 1) * (d - 1) + (d - 1);
+        int k = x - y;
+        bool insert = k == -d || (k != d && prev[k - 1] < prev[k + 1]);
+        int pk = insert ? k + 1 : k - 1;
+        int px = prev[pk];
+        int py = px - pk;
+        script.append({insert, px, py});
+        x = px;
+        y = py;
+    }
+    std::reverse(script.begin(), script.end());
+    return true;
+}
+
+// removed lines of base replaced by added lines at line of current: the
+// first ones are modified, the rest are added or deleted
+void addChange(QVector<LineChange> &changes, int line, int removed, int added)
+{
+    int modified = std::min(removed, added);
+    if(modified > 0)
+        changes.append({LineChange::Modified, line, modified});
+    if(added > modified)
+        changes.append({LineChange::Added, line + modified, added - modified});
+    else if(removed > modified)
+        changes.append({LineChange::Deleted, line + modified, removed - modified});
+}
+
+} // namespace
+
+void ChangeTracker::setBaseline(const QByteArray &text)
+{
+    baseline_ = lineHashes(text);
+}
+
+void ChangeTracker::setText(const QByteArray &text)
+{
+    lines_ = lineHashes(text);
+}
+
+void ChangeTracker::replaceLines(int line, int removed, const QVector<size_t> &hashes)
+{
+    removed = std::min(removed, lines_.size() - line);
+    int common = std::min(removed, hashes.size());
+    std::copy(hashes.begin(), hashes.begin() + common, lines_.begin() + line);
+    if(removed > common)
+        lines_.remove(line + common, removed - common);
+    else if(hashes.size() > common)
+    {
+        lines_.insert(line + common, hashes.size() - common, 0);
+        std::copy(hashes.begin() + common, hashes.end(), lines_.begin() + line + common);
+    }
+}
+
+size_t ChangeTracker::lineHash(const char *s, int len)
+{
+    return qHashBits(s, len, 0);
+}
+
+QVector<size_t> ChangeTracker::lineHashes(const QByteArray &text)
+{
+    QVector<size_t> hashes;
+    const char *s = text.constData();
+    const int n = text.size();
+    int start = 0;
+    for(int i = 0; i < n; i++)
+    {
+        if(s[i] != '\n' && s[i] != '\r') continue;
+        hashes.append(lineHash(s + start, i - start));
+        if(s[i] == '\r' && i + 1 < n && s[i + 1] == '\n') i++;
+        start = i + 1;
+    }
+    hashes.append(lineHash(s + start, n - start));
+    return hashes;
+}
+
+QVector<LineChange> ChangeTracker::diff(const QVector<size_t> &base, const QVector<size_t> &current)
+{
+    QVector<LineChange> changes;
+
+    int head = 0;
+    while(head < base.size() && head < current.size() && base[head] == current[head])
+        head++;
+    int tail = 0;
+    while(tail < base.size() - head && tail < current.size() - head
+            && base[base.size() - 1 - tail] == current[current.size() - 1 - tail])
+        tail++;
+    const int n = base.size() - head - tail;
+    const int m = current.size() - head - tail;
+    if(n == 0 && m == 0) return changes;
+
+    QVector<Edit> script;
+    if(!editScript(base.constData() + head, n, current.constData() + head, m, script))
+    {
+        addChange(changes, head, n, m);
+        return changes;
+    }
+
+    // consecutive edits (not separated by equal lines) make up a change:
+    for(int i = 0; i < script.size(); )
+    {
+        int x = script[i].x, y = script[i].y;
+        int removed = 0, added = 0;
+        for(; i < script.size() && script[i].x == x + removed && script[i].y == y + added; i++)
+            (script[i].insert ? added : removed)++;
+        addChange(changes, head + y, removed, added);
+    }
+    return changes;
+}
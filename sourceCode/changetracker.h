@@ -0,0 +1,55 @@
+#ifndef CHANGETRACKER_H
+#define CHANGETRACKER_H
+
+#include <QByteArray>
+#include <QVector>
+
+// a run of changed lines of the current text
+struct LineChange
+{
+    enum Kind
+    {
+        Added,
+        Modified,
+        Deleted     // lines were removed before line (count is the number of removed lines)
+    };
+
+    Kind kind;
+    int line;
+    int count;
+};
+
+// lines of a document, as hashes, compared with the lines of a baseline
+// text. the hashes of the document are updated from the edits (only the
+// lines touched by an edit are hashed again), and the diff skips the
+// common head and tail before running Myers' algorithm on the rest, so
+// that the cost of an update depends on the size of the changes rather
+// than on the size of the document.
+class ChangeTracker
+{
+public:
+    void setBaseline(const QByteArray &text);
+    void setText(const QByteArray &text);
+
+    // lines [line, line + removed) of the text have been replaced by lines
+    // with the given hashes
+    void replaceLines(int line, int removed, const QVector<size_t> &hashes);
+
+    inline const QVector<size_t> & baseline() const { return baseline_; }
+    inline const QVector<size_t> & lines() const { return lines_; }
+
+    // hash of a line (without its line ending)
+    static size_t lineHash(const char *s, int len);
+
+    // hashes of the lines of text, split like scintilla does (\r\n, \r or \n)
+    static QVector<size_t> lineHashes(const QByteArray &text);
+
+    // changes from base to current, in order of line
+    static QVector<LineChange> diff(const QVector<size_t> &base, const QVector<size_t> &current);
+
+private:
+    QVector<size_t> baseline_;
+    QVector<size_t> lines_;
+};
+
+#endif // CHANGETRACKER_H
@@ -2,15 +2,20 @@
 #include <QDomDocument>
 #include <QDomElement>
 #include <QFileInfo>
+#include <QRegularExpression>
 #include <QByteArray>
 #include <QStringList>
+#include <functional>
 #include "plugin.h"
+#include "stats.h"
 #include <simPlusPlus/Lib.h>
 
 QString EditorOptions::resourcesPath{};
 
 void EditorOptions::readFromXML(const QString &xml)
 {
+    STATS_SCOPE("EditorOptions::readFromXML");
+
     QDomDocument doc;
     doc.setContent(xml.isEmpty() ? "<editor/>" : xml);
     QDomElement e = doc.documentElement();
@@ -87,6 +92,13 @@ void EditorOptions::readFromXML(const QString &xml)
     snippetsGroup = e.attribute("snippets-group", lang);
     onClose = e.attribute("on-close", "");
     wrapWord = parseBool(e.attribute("wrap-word", "false"));
+    devHud = parseBool(e.attribute("dev-hud", "false"));
+    syntaxCheck = parseBool(e.attribute("syntax-check", "true"));
+    largeFileThreshold = e.attribute("large-file-threshold", "2097152").toLongLong();
+    hugeFileThreshold = e.attribute("huge-file-threshold", "16777216").toLongLong();
+    maxUndoMemory = e.attribute("max-undo-memory", "0").toLongLong();
+    maxUndoSteps = e.attribute("max-undo-steps", "0").toInt();
+    maxLoadedFiles = e.attribute("max-loaded-files", "0").toInt();
     text_col = parseColor(e.attribute("text-col", "50 50 50"));
     background_col = parseColor(e.attribute("background-col", "190 190 190"));
     selection_col = parseColor(e.attribute("selection-col", "128 128 255"));
@@ -177,6 +189,97 @@ QString EditorOptions::resolveScriptFilePath(const QString &f_)
     return "";
 }
 
+static void getFunctionDefs(const EditorOptions &opts, const QString &code, QVector<QString> &names, QVector<int> &pos, const QString &re, std::function<QString(QRegularExpressionMatch)> n, std::function<int(QRegularExpressionMatch)> p)
+{
+    if(opts.lang != "lua" && opts.lang != "python") return;
+    QRegularExpression regexp(re);
+    auto i = regexp.globalMatch(code);
+    while(i.hasNext())
+    {
+        const auto &m = i.next();
+        names.append(n(m));
+        pos.append(p(m));
+    }
+}
+
+void getFunctionDefs(const EditorOptions &opts, const QString &code, QVector<QString> &names, QVector<int> &pos)
+{
+    if(opts.lang == "lua")
+    {
+        getFunctionDefs(opts, code, names, pos,
+            "("
+                "function\\s+([a-zA-Z0-9_.:]+)\\s*(\\([^)]*\\))"
+            "|" "([a-zA-Z0-9_.]+)\\s*=\\s*function\\s*(\\([^)]*\\))"
+            ")",
+            [&] (QRegularExpressionMatch m)
+            {
+                return m.captured(2) + m.captured(3) + m.captured(4) + m.captured(5);
+            },
+            [&] (QRegularExpressionMatch m)
+            {
+                return qMax(m.capturedStart(2), m.capturedStart(4));
+            }
+        );
+    }
+    else if(opts.lang == "python")
+    {
+        getFunctionDefs(opts, code, names, pos,
+            "def\\s+([a-zA-Z0-9_]+)\\s*(\\(.*\\))\\s*:\\s*",
+            [&] (QRegularExpressionMatch m)
+            {
+                return m.captured(1) + m.captured(2);
+            },
+            [&] (QRegularExpressionMatch m)
+            {
+                return m.capturedStart(1);
+            }
+        );
+    }
+}
+
+MemoryUsage & MemoryUsage::operator+=(const MemoryUsage &o)
+{
+    document += o.document;
+    undo += o.undo;
+    styles += o.styles;
+    options += o.options;
+    snippets += o.snippets;
+    pixmaps += o.pixmaps;
+    return *this;
+}
+
+QJsonObject MemoryUsage::toJson() const
+{
+    QJsonObject o;
+    o["document"] = double(document);
+    o["undo"] = double(undo);
+    o["styles"] = double(styles);
+    o["options"] = double(options);
+    o["snippets"] = double(snippets);
+    o["pixmaps"] = double(pixmaps);
+    o["total"] = double(total());
+    return o;
+}
+
+qint64 memoryUsage(const QString &s)
+{
+    return sizeof(QString) + s.capacity() * sizeof(QChar);
+}
+
+qint64 EditorOptions::memoryUsage() const
+{
+    qint64 n = sizeof(EditorOptions);
+    for(const auto &s : {windowTitle, lang, langExt, langComment, snippetsGroup, onClose, fontFace})
+        n += ::memoryUsage(s);
+    for(const auto &s : snippetsPaths)
+        n += ::memoryUsage(s);
+    for(const auto &s : scriptSearchPath)
+        n += ::memoryUsage(s);
+    for(const auto &kw : userKeywords)
+        n += sizeof(UserKeyword) + ::memoryUsage(kw.keyword) + ::memoryUsage(kw.callTip);
+    return n;
+}
+
 char * stringBufferCopy(const QString &str)
 {
     QByteArray byteArr = str.toLocal8Bit();
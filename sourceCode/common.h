@@ -3,9 +3,11 @@
 
 #include <QString>
 #include <QVector>
+#include <QList>
 #include <QColor>
 #include <QSize>
 #include <QPoint>
+#include <QJsonObject>
 
 struct UserKeyword
 {
@@ -15,6 +17,32 @@ struct UserKeyword
     int keywordType;
 };
 
+// estimated memory use, in bytes
+struct MemoryUsage
+{
+    qint64 document {0};
+    qint64 undo {0};
+    qint64 styles {0};
+    qint64 options {0};
+    qint64 snippets {0};
+    qint64 pixmaps {0};
+
+    inline qint64 total() const { return document + undo + styles + options + snippets + pixmaps; }
+    MemoryUsage & operator+=(const MemoryUsage &o);
+    QJsonObject toJson() const;
+};
+
+qint64 memoryUsage(const QString &s);
+
+// what is kept of an external file's editor while it is unloaded
+struct EditorViewState
+{
+    int line {0};
+    int index {0};
+    int firstVisibleLine {0};
+    QList<int> contractedFolds;
+};
+
 struct EditorOptions
 {
     bool toolBar;
@@ -52,6 +80,20 @@ struct EditorOptions
     static QString resourcesPath;
     QString onClose;
     bool wrapWord;
+    bool devHud;
+    bool syntaxCheck;
+    qint64 largeFileThreshold;
+    qint64 hugeFileThreshold;
+    // limits of the undo history (0: unlimited). scintilla can only clear
+    // the whole history, so once over a limit it is cleared when editing
+    // pauses for a moment, or when the text is set, saved or the script
+    // restarted: it can exceed the limit during a burst of edits, and after
+    // a clear no edit made before can be undone
+    qint64 maxUndoMemory;
+    int maxUndoSteps;
+    // number of external files kept loaded (0: unlimited); beyond it, the
+    // least recently active ones are unloaded, keeping only their view state
+    int maxLoadedFiles;
     QString fontFace;
     int fontSize;
     bool fontBold;
@@ -74,9 +116,11 @@ struct EditorOptions
     QVector<QString> scriptSearchPath;
 
     void readFromXML(const QString &xml);
+    qint64 memoryUsage() const;
     QString resolveScriptFilePath(const QString &f);
 };
 
+void getFunctionDefs(const EditorOptions &opts, const QString &code, QVector<QString> &names, QVector<int> &pos);
 char * stringBufferCopy(const QString &str);
 QColor parseColor(const QString &colorStr);
 bool parseBool(const QString &boolStr);
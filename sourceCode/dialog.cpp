@@ -3,8 +3,12 @@
 #include "toolbar.h"
 #include "statusbar.h"
 #include "searchandreplacepanel.h"
+#include "palette.h"
+#include "documentregistry.h"
 #include <simPlusPlus/Lib.h>
 #include "UI.h"
+#include "stats.h"
+#include "idlescheduler.h"
 
 QString Dialog::modalText;
 int Dialog::modalPosAndSize[4];
@@ -30,7 +34,7 @@ Dialog::Dialog(const EditorOptions &o, UI *ui, QWidget* pParent)
         toolBar_->setVisible(false);
     searchPanel_ = new SearchAndReplacePanel(this);
     statusBar_ = new StatusBar(this);
-    if(!o.statusBar)
+    if(!o.statusBar && !o.devHud)
         statusBar_->setVisible(false);
 
     if(o.searchable)
@@ -47,6 +51,10 @@ Dialog::Dialog(const EditorOptions &o, UI *ui, QWidget* pParent)
         activeEditor_->saveExternalFile();
     });
 
+    palette_ = new Palette(this);
+    QShortcut *paletteShortcut = new QShortcut(QKeySequence(tr("Ctrl+p", "Go to anything")), this);
+    connect(paletteShortcut, &QShortcut::activated, palette_, &Palette::popup);
+
     QVBoxLayout *bl = new QVBoxLayout;
     bl->setContentsMargins(0,0,0,0);
     bl->setSpacing(0);
@@ -74,23 +82,27 @@ Dialog::Dialog(const EditorOptions &o, UI *ui, QWidget* pParent)
         activeEditor()->unindentSelectedText();
     });
     connect(toolBar_->openFiles.actSave, &QAction::triggered, [this]() {
-        auto editor = qvariant_cast<Editor*>(toolBar_->openFiles.combo->currentData());
-        if(!editor->externalFile().isEmpty())
+        // unloaded files have no changes to save:
+        auto editor = editors_.value(toolBar_->openFiles.combo->currentData().toString());
+        if(editor && !editor->externalFile().isEmpty())
             editor->saveExternalFile();
     });
     connect(toolBar_->openFiles.actClose, &QAction::triggered, [this]() {
-        auto editor = qvariant_cast<Editor*>(toolBar_->openFiles.combo->currentData());
-        if(!editor->externalFile().isEmpty())
-        {
-            if(editor->needsSaving())
-                if(QMessageBox::Yes != QMessageBox::question(this, "", QStringLiteral("File %1 has not been saved since last change.\n\nAre you sure you want to close it?").arg(editor->externalFile())))
-                    return;
-            closeExternalFile(editor);
-        }
+        QString path = toolBar_->openFiles.combo->currentData().toString();
+        if(path.isEmpty()) return;
+        auto editor = editors_.value(path);
+        // the changes survive in the other windows sharing the document:
+        if(editor && editor->needsSaving() && DocumentRegistry::instance()->editors(editor).size() <= 1)
+            if(QMessageBox::Yes != QMessageBox::question(this, "", QStringLiteral("File %1 has not been saved since last change.\n\nAre you sure you want to close it?").arg(path)))
+                return;
+        closeExternalFile(path);
     });
     connect(toolBar_->openFiles.combo, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), [this] {
-        auto editor = qvariant_cast<Editor*>(toolBar_->openFiles.combo->currentData());
-        switchEditor(editor);
+        QString path = toolBar_->openFiles.combo->currentData().toString();
+        if(path.isEmpty())
+            switchEditor(editors_.value(""));
+        else
+            openExternalFile(path);
     });
 
     connect(searchPanel_, &SearchAndReplacePanel::shown, toolBar_, &ToolBar::updateButtons);
@@ -98,9 +110,14 @@ Dialog::Dialog(const EditorOptions &o, UI *ui, QWidget* pParent)
 
     toolBar_->updateButtons();
 
-    dirtyCheckTimer_ = new QTimer(this);
-    connect(dirtyCheckTimer_, &QTimer::timeout, this, &Dialog::updateReloadButtonVisualClue);
-    dirtyCheckTimer_->setInterval(2000);
+    // compare the script with the text of the last restart once editing pauses:
+    connect(editors_[""], &QsciScintilla::textChanged, [this] {
+        if(!toolBar_->actReload->isEnabled()) return;
+        IdleScheduler::instance()->post(this, "dirtyCheck", IdleScheduler::Low, editors_[""], [this] {
+            updateReloadButtonVisualClue();
+            return false;
+        });
+    });
 
     ui->requestSimulationStatus();
 }
@@ -120,6 +137,7 @@ void Dialog::setEditorOptions(const EditorOptions &o)
     QWidget *parent = (QWidget *)sim::getMainWindow(1);
     setWindowTitle(o.windowTitle);
     statusBar()->setSizeGripEnabled(o.resizable);
+    statusBar()->setHudVisible(o.devHud);
     setModal(o.modal);
     Qt::WindowFlags flags = Qt::CustomizeWindowHint | Qt::WindowTitleHint | Qt::WindowSystemMenuHint; // | Qt::WindowStaysOnTopHint;
 #ifdef MAC_SIM
@@ -174,8 +192,22 @@ Editor * Dialog::activeEditor()
     return activeEditor_;
 }
 
-Editor * Dialog::openExternalFile(const QString &filePath)
+QString Dialog::fileKey(const QString &filePath) const
 {
+    // the same file may be given by another path (relative, with "..",
+    // through a symlink, ...) than the one it was opened with:
+    if(filePath.isEmpty() || editors_.contains(filePath) || unloadedFiles_.contains(filePath))
+        return filePath;
+    QString key = DocumentRegistry::key(filePath);
+    for(const auto &path : editors_.keys() + unloadedFiles_.keys())
+        if(!path.isEmpty() && DocumentRegistry::key(path) == key)
+            return path;
+    return filePath;
+}
+
+Editor * Dialog::openExternalFile(const QString &path)
+{
+    QString filePath = fileKey(path);
     Editor *editor = editors_.value(filePath);
 
     if(!editor)
@@ -185,6 +217,15 @@ Editor * Dialog::openExternalFile(const QString &filePath)
         editor->openExternalFile(filePath);
         editors_.insert(filePath, editor);
         stacked_->addWidget(editor);
+        toolBar_->invalidateOpenFiles();
+
+        // reloading a file that was unloaded:
+        auto it = unloadedFiles_.find(filePath);
+        if(it != unloadedFiles_.end())
+        {
+            editor->setViewState(*it);
+            unloadedFiles_.erase(it);
+        }
     }
 
     switchEditor(editor);
@@ -194,6 +235,13 @@ Editor * Dialog::openExternalFile(const QString &filePath)
 
 void Dialog::closeExternalFile(const QString &filePath)
 {
+    if(unloadedFiles_.remove(filePath))
+    {
+        recentFiles_.removeAll(filePath);
+        toolBar_->invalidateOpenFiles();
+        toolBar_->updateButtons();
+        return;
+    }
     auto editor = editors_.value(filePath);
     if(!editor) return;
     closeExternalFile(editor);
@@ -202,9 +250,11 @@ void Dialog::closeExternalFile(const QString &filePath)
 void Dialog::closeExternalFile(Editor *editor)
 {
     if(editor->externalFile().isNull()) return;
+    recentFiles_.removeAll(editor->externalFile());
     stacked_->removeWidget(editor);
     editors_.remove(editor->externalFile());
     editor->deleteLater();
+    toolBar_->invalidateOpenFiles();
     //toolBar_->updateButtons();
     switchEditor(editors_.value(""));
 }
@@ -215,17 +265,64 @@ void Dialog::switchEditor(Editor *editor)
 
     stacked_->setCurrentWidget(editor);
     activeEditor_ = editor;
+
+    QString path = editor->externalFile();
+    if(!path.isEmpty())
+    {
+        recentFiles_.removeAll(path);
+        recentFiles_.append(path);
+        unloadInactiveFiles();
+    }
+
     toolBar_->updateButtons();
 }
 
+void Dialog::unloadExternalFile(Editor *editor)
+{
+    // keep only what is needed to restore it as it was:
+    QString path = editor->externalFile();
+    unloadedFiles_.insert(path, editor->viewState());
+    stacked_->removeWidget(editor);
+    editors_.remove(path);
+    editor->deleteLater();
+    toolBar_->invalidateOpenFiles();
+}
+
+void Dialog::unloadInactiveFiles()
+{
+    if(opts.maxLoadedFiles <= 0) return;
+
+    // external files loaded (not counting the embedded script):
+    int loaded = editors_.size() - 1;
+    for(int i = 0; i < recentFiles_.size() && loaded > opts.maxLoadedFiles; i++)
+    {
+        Editor *editor = editors_.value(recentFiles_[i]);
+        if(!editor || editor == activeEditor_ || editor->needsSaving() || editor->isSaving())
+            continue;
+        unloadExternalFile(editor);
+        loaded--;
+    }
+}
+
 bool Dialog::containsUnsavedFiles()
 {
     for(auto editor : editors_)
-        if(editor->needsSaving())
+        if(editor->needsSaving() && DocumentRegistry::instance()->editors(editor).size() <= 1)
             return true;
     return false;
 }
 
+MemoryUsage Dialog::memoryUsage()
+{
+    MemoryUsage u;
+    for(auto editor : editors_)
+        u += editor->memoryUsage();
+    u += toolBar_->memoryUsage();
+    // the help page, if loaded:
+    u.document += textBrowser_->document()->characterCount() * sizeof(QChar);
+    return u;
+}
+
 void Dialog::setHandle(int handle)
 {
     this->handle = handle;
@@ -235,6 +332,7 @@ void Dialog::setInitText(const QString &text)
 {
     initText_ = text;
     setText(text);
+    updateChangeBaseline();
 }
 
 void Dialog::setText(const QString &text)
@@ -358,6 +456,8 @@ void Dialog::reject()
 
 void Dialog::updateReloadButtonVisualClue()
 {
+    STATS_SCOPE("Dialog::updateReloadButtonVisualClue");
+
     auto action = toolBar_->actReload;
 
     bool dirty = false;
@@ -379,11 +479,20 @@ void Dialog::updateReloadButtonVisualClue()
     widget->setStyleSheet(ss);
 }
 
+void Dialog::updateChangeBaseline()
+{
+    // show in the margin what a restart of the script would apply:
+    if(opts.canRestartInSim || opts.canRestartInNonsim)
+        editors_[""]->setChangeBaseline(initText_);
+}
+
 void Dialog::reloadScript()
 {
     initText_ = text();
     scriptRestartInitiallyNeeded_ = false;
     updateReloadButtonVisualClue();
+    updateChangeBaseline();
+    editors_[""]->compactUndoHistory();
     ui->notifyEvent(handle, "restartScript", opts.onClose);
 }
 
@@ -396,15 +505,11 @@ void Dialog::onSimulationRunning(bool running)
     else if(!opts.canRestartInNonsim || !opts.canRestartInSim) {
         scriptRestartInitiallyNeeded_ = false;
         initText_ = text();
+        updateChangeBaseline();
     }
 
     toolBar_->actReload->setEnabled(restartButtonEnabled);
     updateReloadButtonVisualClue();
-
-    if(restartButtonEnabled)
-        dirtyCheckTimer_->start();
-    else
-        dirtyCheckTimer_->stop();
 }
 
 void Dialog::updateCursorSelectionDisplay()
@@ -9,6 +9,7 @@ class Editor;
 class ToolBar;
 class StatusBar;
 class SearchAndReplacePanel;
+class Palette;
 
 class Dialog : public QDialog
 {
@@ -26,7 +27,9 @@ public:
     void closeExternalFile(Editor *editor);
     void switchEditor(Editor *editor);
     inline const QMap<QString, Editor*> & editors() {return editors_;}
+    inline const QMap<QString, EditorViewState> & unloadedFiles() {return unloadedFiles_;}
     bool containsUnsavedFiles();
+    MemoryUsage memoryUsage();
 
     void show();
     void hide();
@@ -46,6 +49,9 @@ public:
     void hideHelp();
 protected:
     void showHelp(bool v);
+    void unloadExternalFile(Editor *editor);
+    void unloadInactiveFiles();
+    QString fileKey(const QString &filePath) const;
 
 private:
     void closeEvent(QCloseEvent *event);
@@ -53,6 +59,7 @@ private:
 private slots:
     void reject();
     void updateReloadButtonVisualClue();
+    void updateChangeBaseline();
     void reloadScript();
 public slots:
     void onSimulationRunning(bool running);
@@ -66,11 +73,14 @@ private:
     UI *ui;
     ToolBar *toolBar_;
     QMap<QString, Editor*> editors_;
+    QMap<QString, EditorViewState> unloadedFiles_;
+    QStringList recentFiles_; // least recently used first
     Editor *activeEditor_;
     QStackedWidget *stacked_;
     QTextBrowser *textBrowser_;
     SearchAndReplacePanel *searchPanel_;
     StatusBar *statusBar_;
+    Palette *palette_;
     int handle;
     int scriptTypeOrHandle;
     EditorOptions opts;
@@ -79,7 +89,6 @@ private:
     int memorizedPos[2] = { -999999,-999999 };
     QString initText_;
     bool scriptRestartInitiallyNeeded_ {false};
-    QTimer *dirtyCheckTimer_;
     bool firstTimeSeeingSimulationStatus_ {true};
 
     friend class Toolbar;
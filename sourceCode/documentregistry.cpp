@@ -0,0 +1,67 @@
+#include "documentregistry.h"
+#include "editor.h"
+#include <QDir>
+#include <QFileInfo>
+
+DocumentRegistry * DocumentRegistry::instance()
+{
+    static DocumentRegistry registry;
+    return &registry;
+}
+
+QString DocumentRegistry::key(const QString &path)
+{
+    QFileInfo info(path);
+    QString canonical = info.canonicalFilePath();
+    return canonical.isEmpty() ? QDir::cleanPath(info.absoluteFilePath()) : canonical;
+}
+
+bool DocumentRegistry::attach(Editor *editor, const QString &path)
+{
+    detach(editor);
+
+    QString k = key(path);
+    auto it = entries_.find(k);
+    if(it == entries_.end()) return false;
+
+    bool obs = editor->blockSignals(true);
+    editor->setDocument(it->document);
+    editor->blockSignals(obs);
+    it->editors.append(editor);
+    keys_.insert(editor, k);
+    return true;
+}
+
+void DocumentRegistry::add(Editor *editor, const QString &path)
+{
+    detach(editor);
+
+    QString k = key(path);
+    Entry &e = entries_[k];
+    e.document = editor->document();
+    e.editors = {editor};
+    keys_.insert(editor, k);
+}
+
+void DocumentRegistry::detach(Editor *editor)
+{
+    auto k = keys_.find(editor);
+    if(k == keys_.end()) return;
+
+    auto it = entries_.find(*k);
+    if(it != entries_.end())
+    {
+        it->editors.removeAll(editor);
+        // the last reference to the document is held by the editor itself:
+        if(it->editors.isEmpty())
+            entries_.erase(it);
+    }
+    keys_.erase(k);
+}
+
+QVector<Editor*> DocumentRegistry::editors(const Editor *editor) const
+{
+    auto k = keys_.constFind(editor);
+    if(k == keys_.constEnd()) return {};
+    return entries_.value(*k).editors;
+}
@@ -0,0 +1,44 @@
+#ifndef DOCUMENTREGISTRY_H
+#define DOCUMENTREGISTRY_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <Qsci/qscidocument.h>
+
+class Editor;
+
+// process-wide registry of the documents of external files, keyed by
+// canonical path: all the editors showing the same file share a single
+// scintilla document, so the file is loaded, styled and stored once, and
+// edits (and the modified state) show up in every window
+class DocumentRegistry
+{
+public:
+    static DocumentRegistry * instance();
+
+    // attach the editor to the document of the file, if it is open in
+    // another editor; returns false otherwise (the editor loads the file)
+    bool attach(Editor *editor, const QString &path);
+    // register the document of an editor that has just loaded the file
+    void add(Editor *editor, const QString &path);
+    void detach(Editor *editor);
+    // the editors sharing the document of the given editor, in the
+    // order they were attached (empty if not registered)
+    QVector<Editor*> editors(const Editor *editor) const;
+
+    // canonical form of a path, under which its document is registered
+    static QString key(const QString &path);
+
+private:
+
+    struct Entry
+    {
+        QsciDocument document;
+        QVector<Editor*> editors;
+    };
+    QHash<QString, Entry> entries_;
+    QHash<const Editor*, QString> keys_;
+};
+
+#endif // DOCUMENTREGISTRY_H
@@ -1,7 +1,13 @@
 #include "editor.h"
 #include "dialog.h"
 #include "toolbar.h"
+#include "statusbar.h"
+#include "symbolindex.h"
+#include "documentregistry.h"
+#include "idlescheduler.h"
+#include "stats.h"
 #include "UI.h"
+#include <simPlusPlus/Lib.h>
 #include <SciLexer.h>
 
 #include <Qsci/qscilexer.h>
@@ -54,6 +60,9 @@ Editor::Editor(Dialog *d)
       dialog(d)
 {
     SendScintilla(QsciScintillaBase::SCI_SETSTYLEBITS, 5);
+    // documents are UTF-8: files are loaded as they are (see loadFile), and
+    // byte offsets in the text are positions in the document
+    setUtf8(true);
     setTabWidth(4);
     setTabIndents(true);
     setBackspaceUnindents(true);
@@ -66,6 +75,25 @@ Editor::Editor(Dialog *d)
     connect(this, &QsciScintilla::selectionChanged, this, &Editor::onSelectionChanged);
     connect(this, &QsciScintilla::cursorPositionChanged, this, &Editor::onCursorPosChanged);
     connect(this, SIGNAL(SCN_UPDATEUI(int)), this, SLOT(onUpdateUi(int)));
+    connect(this, SIGNAL(SCN_DWELLSTART(int,int,int)), this, SLOT(onDwellStart(int,int,int)));
+    connect(this, SIGNAL(SCN_DWELLEND(int,int,int)), this, SLOT(onDwellEnd(int,int,int)));
+
+    // syntax is checked once typing pauses:
+    syntaxCheckTimer_ = new QTimer(this);
+    syntaxCheckTimer_->setSingleShot(true);
+    syntaxCheckTimer_->setInterval(500);
+    connect(syntaxCheckTimer_, &QTimer::timeout, this, &Editor::checkSyntax);
+
+    // the undo history is capped once editing pauses:
+    undoLimitTimer_ = new QTimer(this);
+    undoLimitTimer_->setSingleShot(true);
+    undoLimitTimer_->setInterval(2000);
+    connect(undoLimitTimer_, &QTimer::timeout, this, &Editor::compactUndoHistory);
+}
+
+Editor::~Editor()
+{
+    DocumentRegistry::instance()->detach(this);
 }
 
 bool Editor::isActive() const
@@ -146,7 +174,16 @@ void Editor::setEditorOptions(const EditorOptions &o)
         SendScintilla(QsciScintillaBase::SCI_SETMARGINWIDTHN, (unsigned long)0, (long)48);
         setAStyle(QsciScintillaBase::STYLE_LINENUMBER, (unsigned long)QColor(Qt::white).rgb(), (long)QColor(Qt::darkGray).rgb());
     }
-    SendScintilla(QsciScintillaBase::SCI_SETMARGINWIDTHN, (unsigned long)1, (long)0);
+    syntaxChecker_.reset(o.syntaxCheck ? SyntaxChecker::create(o.lang) : nullptr);
+    outline_.clear();
+    styleOutline_.reset(o.lang);
+    invalidateOutline(0);
+    SendScintilla(QsciScintillaBase::SCI_SETMARGINTYPEN, (unsigned long)1, (long)QsciScintillaBase::SC_MARGIN_SYMBOL);
+    SendScintilla(QsciScintillaBase::SCI_SETMARGINMASKN, (unsigned long)1, (long)((1 << 10) | (1 << 11)));
+    SendScintilla(QsciScintillaBase::SCI_SETMARGINWIDTHN, (unsigned long)1, (long)(syntaxChecker_ ? 14 : 0));
+    SendScintilla(QsciScintillaBase::SCI_SETMARGINTYPEN, (unsigned long)3, (long)QsciScintillaBase::SC_MARGIN_SYMBOL);
+    SendScintilla(QsciScintillaBase::SCI_SETMARGINMASKN, (unsigned long)3, (long)((1 << 12) | (1 << 13) | (1 << 14)));
+    SendScintilla(QsciScintillaBase::SCI_SETMARGINWIDTHN, (unsigned long)3, (long)(changeTracker_ ? 5 : 0));
     SendScintilla(QsciScintillaBase::SCI_SETSELBACK,(unsigned long)1,(long)o.selection_col.rgb()); // selection color
 
     SendScintilla(QsciScintillaBase::SCI_INDICSETSTYLE, (unsigned long)20, (long)QsciScintillaBase::INDIC_STRAIGHTBOX);
@@ -278,6 +315,39 @@ void Editor::setEditorOptions(const EditorOptions &o)
     SendScintilla(QsciScintillaBase::SCI_INDICSETALPHA,(unsigned long)20,(long)160);
     SendScintilla(QsciScintillaBase::SCI_INDICSETFORE,(unsigned long)20,(long)o.selection_col.rgb());
 
+    // find all matches:
+    SendScintilla(QsciScintillaBase::SCI_INDICSETSTYLE,(unsigned long)21,(long)QsciScintillaBase::INDIC_ROUNDBOX);
+    SendScintilla(QsciScintillaBase::SCI_INDICSETALPHA,(unsigned long)21,(long)100);
+    SendScintilla(QsciScintillaBase::SCI_INDICSETFORE,(unsigned long)21,(long)QColor(255, 160, 0).rgb());
+
+    // syntax errors and warnings:
+    SendScintilla(QsciScintillaBase::SCI_INDICSETSTYLE,(unsigned long)22,(long)QsciScintillaBase::INDIC_SQUIGGLE);
+    SendScintilla(QsciScintillaBase::SCI_INDICSETFORE,(unsigned long)22,(long)QColor(Qt::red).rgb());
+    SendScintilla(QsciScintillaBase::SCI_INDICSETSTYLE,(unsigned long)23,(long)QsciScintillaBase::INDIC_SQUIGGLE);
+    SendScintilla(QsciScintillaBase::SCI_INDICSETFORE,(unsigned long)23,(long)QColor(255, 160, 0).rgb());
+    SendScintilla(QsciScintillaBase::SCI_MARKERDEFINE,(unsigned long)10,(long)QsciScintillaBase::SC_MARK_CIRCLE);
+    SendScintilla(QsciScintillaBase::SCI_MARKERSETFORE,(unsigned long)10,(long)QColor(Qt::red).rgb());
+    SendScintilla(QsciScintillaBase::SCI_MARKERSETBACK,(unsigned long)10,(long)QColor(Qt::red).rgb());
+    SendScintilla(QsciScintillaBase::SCI_MARKERDEFINE,(unsigned long)11,(long)QsciScintillaBase::SC_MARK_CIRCLE);
+    SendScintilla(QsciScintillaBase::SCI_MARKERSETFORE,(unsigned long)11,(long)QColor(255, 160, 0).rgb());
+    SendScintilla(QsciScintillaBase::SCI_MARKERSETBACK,(unsigned long)11,(long)QColor(255, 160, 0).rgb());
+
+    // lines changed since the last restart (added, modified, deleted):
+    SendScintilla(QsciScintillaBase::SCI_MARKERDEFINE,(unsigned long)12,(long)QsciScintillaBase::SC_MARK_FULLRECT);
+    SendScintilla(QsciScintillaBase::SCI_MARKERSETBACK,(unsigned long)12,(long)QColor(80, 180, 80).rgb());
+    SendScintilla(QsciScintillaBase::SCI_MARKERDEFINE,(unsigned long)13,(long)QsciScintillaBase::SC_MARK_FULLRECT);
+    SendScintilla(QsciScintillaBase::SCI_MARKERSETBACK,(unsigned long)13,(long)QColor(80, 130, 220).rgb());
+    SendScintilla(QsciScintillaBase::SCI_MARKERDEFINE,(unsigned long)14,(long)QsciScintillaBase::SC_MARK_ARROW);
+    SendScintilla(QsciScintillaBase::SCI_MARKERSETFORE,(unsigned long)14,(long)QColor(Qt::red).rgb());
+    SendScintilla(QsciScintillaBase::SCI_MARKERSETBACK,(unsigned long)14,(long)QColor(Qt::red).rgb());
+    SendScintilla(QsciScintillaBase::SCI_SETMOUSEDWELLTIME,(unsigned long)(syntaxChecker_ ? 500 : QsciScintillaBase::SC_TIME_FOREVER));
+    setDiagnostics({});
+    if(syntaxChecker_)
+        syntaxCheckTimer_->start();
+
+    // the options above may have turned wrapping and folding back on:
+    applyHugeFileMode();
+
 #if 0
     SendScintilla(QsciScintillaBase::SCI_STYLESETHOTSPOT, SCE_LUA_WORD2, 1);
     setHotspotUnderline(true);
@@ -285,35 +355,50 @@ void Editor::setEditorOptions(const EditorOptions &o)
 }
 
 void Editor::onUpdateUi(int updated)
-{   // highlight all occurences of selected text:
+{
+    STATS_SCOPE("Editor::onUpdateUi");
+
+    if(updated & (QsciScintillaBase::SC_UPDATE_CONTENT | QsciScintillaBase::SC_UPDATE_V_SCROLL))
+        markVisibleSearchMatches();
+
+    // highlight all occurences of selected text:
+    if(largeFile_) return;
+    if(!(updated & (QsciScintillaBase::SC_UPDATE_CONTENT | QsciScintillaBase::SC_UPDATE_SELECTION))) return;
+
     SendScintilla(QsciScintillaBase::SCI_SETINDICATORCURRENT, (int)20);
 
     int totTextLength = SendScintilla(QsciScintillaBase::SCI_GETLENGTH);
     SendScintilla(QsciScintillaBase::SCI_INDICATORCLEARRANGE, (unsigned long)0, (long)totTextLength);
 
     int txtL = SendScintilla(QsciScintillaBase::SCI_GETSELTEXT, (unsigned long)0, (long)0) - 1;
-    if (txtL >= 1)
+    if (txtL < 1)
     {
-        int selStart = SendScintilla(QsciScintillaBase::SCI_GETSELECTIONSTART);
+        IdleScheduler::instance()->cancel(this, "occurrences");
+        return;
+    }
 
-        char* txt = new char[txtL + 1];
-        SendScintilla(QsciScintillaBase::SCI_GETSELTEXT, (unsigned long)0, txt);
+    int selStart = SendScintilla(QsciScintillaBase::SCI_GETSELECTIONSTART);
+    QByteArray txt(txtL + 1, '\0');
+    SendScintilla(QsciScintillaBase::SCI_GETSELTEXT, (unsigned long)0, txt.data());
+    txt.resize(qstrlen(txt.constData()));
 
+    // the search runs in idle time, a bounded number of matches at a time:
+    int from = 0;
+    IdleScheduler::instance()->post(this, "occurrences", IdleScheduler::Normal, this, [=]() mutable {
+        SendScintilla(QsciScintillaBase::SCI_SETINDICATORCURRENT, (int)20);
         SendScintilla(QsciScintillaBase::SCI_SETSEARCHFLAGS, QsciScintillaBase::SCFIND_MATCHCASE | QsciScintillaBase::SCFIND_WHOLEWORD);
-        SendScintilla(QsciScintillaBase::SCI_SETTARGETSTART, (int)0);
-        SendScintilla(QsciScintillaBase::SCI_SETTARGETEND, (int)totTextLength);
-
-        int p = SendScintilla(QsciScintillaBase::SCI_SEARCHINTARGET, (unsigned long)txtL, txt);
-        while (p != -1)
+        for(int n = 0; n < 256; n++)
         {
-            if (p != selStart)
-                SendScintilla(QsciScintillaBase::SCI_INDICATORFILLRANGE, (unsigned long)p, (long)strlen(txt));
-            SendScintilla(QsciScintillaBase::SCI_SETTARGETSTART, (int)p + 1);
+            SendScintilla(QsciScintillaBase::SCI_SETTARGETSTART, (int)from);
             SendScintilla(QsciScintillaBase::SCI_SETTARGETEND, (int)totTextLength);
-            p = SendScintilla(QsciScintillaBase::SCI_SEARCHINTARGET, (unsigned long)txtL, txt);
+            int p = SendScintilla(QsciScintillaBase::SCI_SEARCHINTARGET, (unsigned long)txtL, txt.constData());
+            if(p == -1) return false;
+            if (p != selStart)
+                SendScintilla(QsciScintillaBase::SCI_INDICATORFILLRANGE, (unsigned long)p, (long)txt.size());
+            from = p + 1;
         }
-        delete[] txt;
-    }
+        return true;
+    });
 }
 
 static QString stripQuotes(const QString &s)
@@ -349,6 +434,9 @@ void Editor::contextMenuEvent(QContextMenuEvent *event)
         }
     }
 
+    if(!tok.isEmpty())
+        addGoToDefinitionActions(menu, tok);
+
     for(const auto &k : opts.userKeywords)
     {
         if(k.keyword == tok)
@@ -396,6 +484,49 @@ void Editor::contextMenuEvent(QContextMenuEvent *event)
     delete menu;
 }
 
+void Editor::addGoToDefinitionActions(QMenu *menu, const QString &tok)
+{
+    // definitions in the current document come first (from the outline,
+    // which is kept up to date in the background):
+    if(hasOutline())
+    {
+        for(const auto &entry : outline_)
+        {
+            if(SymbolIndex::symbolName(entry.name) != tok) continue;
+            int line = entry.line;
+            menu->addSeparator();
+            connect(menu->addAction(QStringLiteral("Go to definition of '%1'").arg(tok)), &QAction::triggered, [=] {
+                setCursorPosition(line, 0);
+                ensureLineVisible(line);
+            });
+            return;
+        }
+    }
+
+    // then definitions in the files of the search paths:
+    auto locations = SymbolIndex::instance()->lookup(tok, opts.lang, opts.scriptSearchPath);
+    int sep = qMax(tok.lastIndexOf('.'), tok.lastIndexOf(':'));
+    if(locations.isEmpty() && sep >= 0)
+        locations = SymbolIndex::instance()->lookup(tok.mid(sep + 1), opts.lang, opts.scriptSearchPath);
+    if(locations.isEmpty()) return;
+
+    menu->addSeparator();
+    const int maxLocations = 10;
+    for(int i = 0; i < locations.size() && i < maxLocations; i++)
+    {
+        SymbolLocation loc = locations[i];
+        QString label = locations.size() == 1
+            ? QStringLiteral("Go to definition of '%1'").arg(tok)
+            : QStringLiteral("Go to definition of '%1' in %2:%3").arg(tok, elideLeft(QDir::cleanPath(loc.file), 50)).arg(loc.line + 1);
+        connect(menu->addAction(label), &QAction::triggered, [=] {
+            Editor *editor = dialog->openExternalFile(loc.file);
+            if(!editor) return;
+            editor->setCursorPosition(loc.line, 0);
+            editor->ensureLineVisible(loc.line);
+        });
+    }
+}
+
 QString Editor::tokenAtPosition(int pos)
 {
     QString txt{text()};
@@ -452,6 +583,42 @@ QString Editor::tokenAtPosition2(int pos)
     return txt;
 }
 
+void Editor::keyPressEvent(QKeyEvent *event)
+{
+    // measure time from key event to the next paint (dev-hud), only for
+    // presses which change the text, the selection or the scrolling, as
+    // the others (modifiers, keys eaten, ...) wait for the caret blink:
+    if(!opts.devHud || keyPressTime_.isValid())
+    {
+        QsciScintilla::keyPressEvent(event);
+        return;
+    }
+    QElapsedTimer t;
+    t.start();
+    quint64 rev = revision_;
+    long pos = SendScintilla(QsciScintillaBase::SCI_GETCURRENTPOS);
+    long anchor = SendScintilla(QsciScintillaBase::SCI_GETANCHOR);
+    long first = SendScintilla(QsciScintillaBase::SCI_GETFIRSTVISIBLELINE);
+    long xOffset = SendScintilla(QsciScintillaBase::SCI_GETXOFFSET);
+    QsciScintilla::keyPressEvent(event);
+    if(rev != revision_
+            || pos != SendScintilla(QsciScintillaBase::SCI_GETCURRENTPOS)
+            || anchor != SendScintilla(QsciScintillaBase::SCI_GETANCHOR)
+            || first != SendScintilla(QsciScintillaBase::SCI_GETFIRSTVISIBLELINE)
+            || xOffset != SendScintilla(QsciScintillaBase::SCI_GETXOFFSET))
+        keyPressTime_ = t;
+}
+
+void Editor::paintEvent(QPaintEvent *event)
+{
+    QsciScintilla::paintEvent(event);
+    if(keyPressTime_.isValid())
+    {
+        dialog->statusBar()->recordKeyLatency(keyPressTime_.nsecsElapsed());
+        keyPressTime_.invalidate();
+    }
+}
+
 int Editor::positionFromPoint(const QPoint &p)
 {
     return SendScintilla(SCI_POSITIONFROMPOINT, (long)p.x(), (long)p.y());
@@ -464,6 +631,8 @@ QString Editor::tokenAt(const QPoint &p)
 
 void Editor::setText(const char* txt, int insertMode)
 {
+    STATS_SCOPE("Editor::setText");
+
     if (insertMode == 0)
         QsciScintilla::setText(txt);
     else
@@ -482,6 +651,8 @@ void Editor::setText(const char* txt, int insertMode)
         SendScintilla(QsciScintillaBase::SCI_GOTOPOS, (int)SendScintilla(QsciScintillaBase::SCI_POSITIONFROMLINE, (int)SendScintilla(QsciScintillaBase::SCI_GETLINECOUNT) - 1)); // set the cursor and move the view into position
     if (ro)
         SendScintilla(QsciScintillaBase::SCI_SETREADONLY, (int)1);
+    // (text appended frequently, e.g. by a script, grows the history fast)
+    compactUndoHistory();
 }
 
 void Editor::setAStyle(int style,QColor fore,QColor back,int size,const char *face,bool bold)
@@ -499,6 +670,8 @@ void Editor::setAStyle(int style,QColor fore,QColor back,int size,const char *fa
 
 void Editor::onCharAdded(int charAdded)
 {
+    STATS_SCOPE("Editor::onCharAdded");
+
     auto scintilla_ = this;
     if (scintilla_->SendScintilla(QsciScintillaBase::SCI_AUTOCACTIVE)!=0)
     { // Autocomplete is active
@@ -655,15 +828,273 @@ void Editor::onCharAdded(int charAdded)
     }
 }
 
-void Editor::onModified(int, int, const char *, int, int, int, int, int, int, int)
+void Editor::onModified(int position, int modificationType, const char *, int length, int linesAdded, int line, int, int, int, int)
+{
+    if(modificationType & (QsciScintillaBase::SC_MOD_INSERTTEXT | QsciScintillaBase::SC_MOD_DELETETEXT))
+    {
+        // the work here is proportional to the size of the change, and the
+        // syntax check, outline and diff are only scheduled, so that the
+        // notifications of a replace all or of a long undo batch up
+        revision_++;
+        if(syntaxChecker_)
+            syntaxCheckTimer_->start();
+        int first = SendScintilla(QsciScintillaBase::SCI_LINEFROMPOSITION, (unsigned long)position);
+        invalidateOutline(first);
+
+        if(changeTracker_)
+        {
+            // hash again the lines spanned by the change (after the change):
+            int last = first + qMax(0, linesAdded);
+            int start = SendScintilla(QsciScintillaBase::SCI_POSITIONFROMLINE, (unsigned long)first);
+            int end = SendScintilla(QsciScintillaBase::SCI_GETLINEENDPOSITION, (unsigned long)last);
+            QByteArray text(end - start + 1, '\0');
+            SendScintilla(QsciScintillaBase::SCI_GETTEXTRANGE, (long)start, (long)end, text.data());
+            text.resize(end - start);
+            changeTracker_->replaceLines(first, 1 + qMax(0, -linesAdded), ChangeTracker::lineHashes(text));
+            updateLineChanges();
+        }
+
+        // scintilla doesn't report the size of its undo history, keep an
+        // estimate (text of the action plus the action itself):
+        if(!(modificationType & (QsciScintillaBase::SC_PERFORMED_UNDO | QsciScintillaBase::SC_PERFORMED_REDO))
+                && SendScintilla(QsciScintillaBase::SCI_GETUNDOCOLLECTION))
+        {
+            undoBytes_ += length + 32;
+            if(modificationType & QsciScintillaBase::SC_STARTACTION)
+                undoSteps_++;
+            if(undoLimitExceeded())
+                undoLimitTimer_->start();
+        }
+    }
+}
+
+EditorViewState Editor::viewState()
+{
+    EditorViewState state;
+    getCursorPosition(&state.line, &state.index);
+    state.firstVisibleLine = firstVisibleLine();
+    state.contractedFolds = contractedFolds();
+    return state;
+}
+
+void Editor::setViewState(const EditorViewState &state)
+{
+    setContractedFolds(state.contractedFolds);
+    setCursorPosition(state.line, state.index);
+    setFirstVisibleLine(state.firstVisibleLine);
+}
+
+bool Editor::undoLimitExceeded() const
+{
+    return (opts.maxUndoMemory > 0 && undoBytes_ > opts.maxUndoMemory)
+        || (opts.maxUndoSteps > 0 && undoSteps_ > opts.maxUndoSteps);
+}
+
+void Editor::compactUndoHistory()
+{
+    if(!undoLimitExceeded()) return;
+
+    // scintilla can't drop only the oldest actions, so the whole history
+    // is cleared; this is done when editing pauses (not while typing, so
+    // that what is being typed can be undone), when the text is set, and
+    // when it is saved or applied. the history belongs to the document,
+    // shared by all of its views:
+    SendScintilla(QsciScintillaBase::SCI_EMPTYUNDOBUFFER);
+    QVector<Editor*> views = DocumentRegistry::instance()->editors(this);
+    if(views.isEmpty()) views.append(this);
+    for(auto editor : views)
+    {
+        editor->undoBytes_ = 0;
+        editor->undoSteps_ = 0;
+        editor->dialog->toolBar()->updateButtons();
+    }
+    if(dialog->statusBar()->isVisible())
+        dialog->statusBar()->showMessage("Undo history exceeded its limit and has been cleared.", 4000);
+}
+
+struct SyntaxCheckResult
+{
+    QVector<Diagnostic> diagnostics;
+    QVector<OutlineEntry> outline;
+};
+
+void Editor::checkSyntax()
+{
+    if(!syntaxChecker_) return;
+    if(hugeFile_ && !syntaxChecker_->supportsHugeFiles()) return;
+
+    auto checker = syntaxChecker_;
+    runAnalysis<SyntaxCheckResult>(this, snapshot(), [checker] (const DocumentSnapshot &snapshot) {
+        SyntaxCheckResult result;
+        result.diagnostics = checker->run(snapshot.text, &result.outline);
+        return result;
+    }, [this] (const SyntaxCheckResult &result) {
+        setDiagnostics(result.diagnostics);
+        if(hasOutline())
+        {
+            outline_ = result.outline;
+            if(dialog->activeEditor() == this)
+                dialog->toolBar()->updateButtons();
+        }
+    });
+}
+
+bool Editor::hasOutline() const
+{
+    if(syntaxChecker_ && syntaxChecker_->providesOutline()) return true;
+    return StyleOutline::supports(opts.lang) && !largeFile_;
+}
+
+void Editor::invalidateOutline(int line)
+{
+    if(!StyleOutline::supports(opts.lang) || largeFile_) return;
+    styleOutline_.invalidate(line);
+
+    // scan the rest in idle time, a chunk of lines per step, styling it
+    // first if the lexer didn't get there yet:
+    IdleScheduler::instance()->post(this, "outline", IdleScheduler::Low, this, [this] {
+        STATS_SCOPE("Editor::updateOutline");
+        if(largeFile_) return false;
+        int lines = SendScintilla(QsciScintillaBase::SCI_GETLINECOUNT);
+        int first = styleOutline_.scannedLines();
+        if(first < lines)
+        {
+            int last = qMin(lines, first + StyleOutline::chunkLines);
+            int start = SendScintilla(QsciScintillaBase::SCI_POSITIONFROMLINE, (unsigned long)first);
+            int end = last < lines ? SendScintilla(QsciScintillaBase::SCI_POSITIONFROMLINE, (unsigned long)last) : SendScintilla(QsciScintillaBase::SCI_GETLENGTH);
+            SendScintilla(QsciScintillaBase::SCI_COLOURISE, (unsigned long)SendScintilla(QsciScintillaBase::SCI_GETENDSTYLED), (long)end);
+            QByteArray styled(2 * (end - start) + 2, '\0');
+            SendScintilla(QsciScintillaBase::SCI_GETSTYLEDTEXT, (long)start, (long)end, styled.data());
+            styled.resize(2 * (end - start));
+            styleOutline_.scan(styled, last - first);
+            if(last < lines) return true;
+        }
+        outline_ = styleOutline_.entries();
+        if(dialog->activeEditor() == this)
+            dialog->toolBar()->updateButtons();
+        return false;
+    });
+}
+
+void Editor::setChangeBaseline(const QString &text)
+{
+    STATS_SCOPE("Editor::setChangeBaseline");
+
+    // lines are compared as encoded in the document:
+    if(!changeTracker_) changeTracker_.reset(new ChangeTracker);
+    changeTracker_->setBaseline(text.toUtf8());
+    changeTracker_->setText(utf8Text());
+    SendScintilla(QsciScintillaBase::SCI_SETMARGINWIDTHN, (unsigned long)3, (long)5);
+    updateLineChanges();
+}
+
+void Editor::updateLineChanges()
+{
+    // the hashes of the lines are up to date, diff them in the background
+    // once editing pauses:
+    IdleScheduler::instance()->post(this, "lineChanges", IdleScheduler::Low, this, [this] {
+        if(!changeTracker_) return false;
+        QVector<size_t> baseline = changeTracker_->baseline(), lines = changeTracker_->lines();
+        DocumentSnapshot s;
+        s.revision = revision_;
+        runAnalysis<QVector<LineChange>>(this, s, [baseline, lines] (const DocumentSnapshot &) {
+            return ChangeTracker::diff(baseline, lines);
+        }, [this] (const QVector<LineChange> &changes) {
+            setLineChanges(changes);
+        });
+        return false;
+    });
+}
+
+void Editor::setLineChanges(const QVector<LineChange> &changes)
+{
+    STATS_SCOPE("Editor::setLineChanges");
+
+    for(int marker : {12, 13, 14})
+        SendScintilla(QsciScintillaBase::SCI_MARKERDELETEALL, marker);
+    int lastLine = SendScintilla(QsciScintillaBase::SCI_GETLINECOUNT) - 1;
+    for(const auto &c : changes)
+    {
+        // deleted lines are marked on the line that follows them:
+        if(c.kind == LineChange::Deleted)
+            SendScintilla(QsciScintillaBase::SCI_MARKERADD, (unsigned long)qMin(c.line, lastLine), (long)14);
+        else
+            for(int line = c.line; line < c.line + c.count; line++)
+                SendScintilla(QsciScintillaBase::SCI_MARKERADD, (unsigned long)line, (long)(c.kind == LineChange::Added ? 12 : 13));
+    }
+}
+
+void Editor::setDiagnostics(const QVector<Diagnostic> &diagnostics)
+{
+    STATS_SCOPE("Editor::setDiagnostics");
+
+    diagnostics_ = diagnostics;
+    int length = SendScintilla(QsciScintillaBase::SCI_GETLENGTH);
+    for(int indicator : {22, 23})
+    {
+        SendScintilla(QsciScintillaBase::SCI_SETINDICATORCURRENT, indicator);
+        SendScintilla(QsciScintillaBase::SCI_INDICATORCLEARRANGE, (unsigned long)0, (long)length);
+    }
+    SendScintilla(QsciScintillaBase::SCI_MARKERDELETEALL, 10);
+    SendScintilla(QsciScintillaBase::SCI_MARKERDELETEALL, 11);
+    for(const auto &d : diagnostics)
+    {
+        bool warning = d.severity == Diagnostic::Warning;
+        SendScintilla(QsciScintillaBase::SCI_SETINDICATORCURRENT, warning ? 23 : 22);
+        SendScintilla(QsciScintillaBase::SCI_INDICATORFILLRANGE, (unsigned long)d.start, (long)qMax(1, d.length));
+        SendScintilla(QsciScintillaBase::SCI_MARKERADD, (unsigned long)d.line, (long)(warning ? 11 : 10));
+    }
+}
+
+void Editor::onDwellStart(int position, int x, int y)
 {
+    if(position < 0) return;
 
+    for(const auto &d : diagnostics_)
+    {
+        if(position < d.start || position > d.start + qMax(1, d.length)) continue;
+        SendScintilla(QsciScintillaBase::SCI_CALLTIPSHOW, (unsigned long)position, d.message.toUtf8().constData());
+        diagnosticTipShown_ = true;
+        return;
+    }
+}
+
+void Editor::onDwellEnd(int position, int x, int y)
+{
+    if(!diagnosticTipShown_) return;
+    SendScintilla(QsciScintillaBase::SCI_CALLTIPCANCEL);
+    diagnosticTipShown_ = false;
+}
+
+MemoryUsage Editor::memoryUsage()
+{
+    MemoryUsage u;
+    qint64 length = SendScintilla(QsciScintillaBase::SCI_GETLENGTH);
+    qint64 lines = SendScintilla(QsciScintillaBase::SCI_GETLINECOUNT);
+    // text (gap buffer) and line starts; one style byte per character:
+    // a document shared with other windows is accounted to the first view:
+    if(DocumentRegistry::instance()->editors(this).value(0, this) == this)
+    {
+        u.document = length + lines * 2 * sizeof(int);
+        u.styles = length;
+        u.undo = undoBytes_;
+    }
+    // hashes of the lines, and of the lines of the last restarted script:
+    if(changeTracker_)
+        u.document += (changeTracker_->lines().size() + changeTracker_->baseline().size()) * sizeof(size_t);
+    u.options = opts.memoryUsage();
+    return u;
 }
 
 void Editor::onTextChanged()
 {
-    if(!externalFile_.path.isEmpty())
+    STATS_SCOPE("Editor::onTextChanged");
+
+    if(!externalFile_.path.isEmpty() && !externalFile_.edited)
+    {
         externalFile_.edited = true;
+        dialog->toolBar()->invalidateOpenFiles();
+    }
     dialog->toolBar()->updateButtons();
 }
 
@@ -705,37 +1136,196 @@ void Editor::openExternalFile(const QString &filePath)
 {
     externalFile_.path = filePath;
     externalFile_.edited = false;
+    externalFile_.saveError.clear();
+    externalFile_.saving = false;
 
     if(filePath.isNull()) return;
 
-    QFile f(filePath);
-    if(f.open(QIODevice::ReadOnly))
+    auto registry = DocumentRegistry::instance();
+    if(registry->attach(this, filePath))
     {
-        QString content = f.readAll();
-        f.close();
+        // already open in another window: share its document (text,
+        // styles, undo history) instead of loading the file again
+        setFileSize(SendScintilla(QsciScintillaBase::SCI_GETLENGTH));
+        for(auto editor : registry->editors(this))
+            if(editor != this)
+                externalFile_.edited = editor->needsSaving();
+    }
+    else
+    {
+        QFile f(filePath);
+        if(f.open(QIODevice::ReadOnly))
+        {
+            setFileSize(f.size());
 
-        bool obs = blockSignals(true);
-        setText(content.toUtf8().data(), 0);
-        blockSignals(obs);
+            bool obs = blockSignals(true);
+            loadFile(f);
+            blockSignals(obs);
+            f.close();
+            registry->add(this, filePath);
+        }
     }
+    if(syntaxChecker_)
+        syntaxCheckTimer_->start();
+    outline_.clear();
+    styleOutline_.reset(opts.lang);
+    invalidateOutline(0);
     QFileInfo i(filePath);
     setReadOnly(!i.isWritable());
     dialog->toolBar()->updateButtons();
 }
 
+void Editor::setFileSize(qint64 size)
+{
+    largeFile_ = opts.largeFileThreshold > 0 && size >= opts.largeFileThreshold;
+    hugeFile_ = opts.hugeFileThreshold > 0 && size >= opts.hugeFileThreshold;
+
+    applyHugeFileMode();
+
+    if(largeFile_)
+    {
+        dialog->statusBar()->showMessage(QStringLiteral("Large file (%1 MB): some features have been disabled.").arg(size / 1048576.0, 0, 'f', 1), 8000);
+    }
+}
+
+void Editor::applyHugeFileMode()
+{
+    if(!hugeFile_) return;
+    // wrapping and folding need a full layout/fold pass over the document:
+    SendScintilla(QsciScintillaBase::SCI_SETWRAPMODE, QsciScintillaBase::SC_WRAP_NONE);
+    setFolding(QsciScintilla::NoFoldStyle);
+}
+
+void Editor::loadFile(QFile &f)
+{
+    const qint64 chunkSize = 1 << 20;
+    const qint64 size = f.size();
+
+    // signals are blocked while loading (so onModified doesn't see it), and
+    // events are processed for the progress dialog: the tasks and analyses
+    // bound to the current revision must not run on the half-loaded
+    // document, and those started meanwhile are dropped once it is loaded:
+    revision_++;
+
+    // map the file instead of copying it, and feed it to scintilla in chunks:
+    QByteArray buf;
+    const char *data = reinterpret_cast<const char *>(f.map(0, size));
+    if(!data && size > 0)
+    {
+        buf = f.readAll();
+        data = buf.constData();
+    }
+
+    bool ro = isReadOnly();
+    SendScintilla(QsciScintillaBase::SCI_SETREADONLY, (int)0);
+    SendScintilla(QsciScintillaBase::SCI_SETUNDOCOLLECTION, (int)0);
+    SendScintilla(QsciScintillaBase::SCI_CLEARALL);
+    SendScintilla(QsciScintillaBase::SCI_ALLOCATE, (unsigned long)size + 1);
+
+    QProgressDialog *progress = nullptr;
+    if(size > 4 * chunkSize)
+    {
+        progress = new QProgressDialog(QStringLiteral("Loading %1...").arg(QFileInfo(f.fileName()).fileName()), QString(), 0, 100, dialog);
+        progress->setWindowModality(Qt::WindowModal);
+        progress->setMinimumDuration(500);
+    }
+
+    for(qint64 offset = 0; offset < size; offset += chunkSize)
+    {
+        qint64 n = qMin(chunkSize, size - offset);
+        SendScintilla(QsciScintillaBase::SCI_APPENDTEXT, (unsigned long)n, data + offset);
+        if(progress)
+        {
+            progress->setValue(int(100 * (offset + n) / size));
+            QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+        }
+    }
+
+    delete progress;
+    if(buf.isNull()) f.unmap(reinterpret_cast<uchar *>(const_cast<char *>(data)));
+
+    SendScintilla(QsciScintillaBase::SCI_SETUNDOCOLLECTION, (int)1);
+    SendScintilla(QsciScintillaBase::SCI_EMPTYUNDOBUFFER);
+    undoBytes_ = 0;
+    undoSteps_ = 0;
+    SendScintilla(QsciScintillaBase::SCI_SETSAVEPOINT);
+    SendScintilla(QsciScintillaBase::SCI_GOTOPOS, (int)0);
+    if(ro)
+        SendScintilla(QsciScintillaBase::SCI_SETREADONLY, (int)1);
+    revision_++;
+}
+
 void Editor::saveExternalFile()
 {
     if(externalFile_.path.isEmpty()) return;
 
-    QFile f(externalFile_.path);
-    if(f.open(QIODevice::WriteOnly))
+    if(externalFile_.saving)
     {
-        f.write(text().toUtf8());
-        f.close();
-        externalFile_.edited = false;
-        dialog->toolBar()->updateButtons();
+        dialog->statusBar()->showMessage(QStringLiteral("File %1 is still being saved.").arg(externalFile_.path), 4000);
+        return;
     }
-    else QMessageBox::information(parentWidget(), "", QStringLiteral("Cannot write to file %1.").arg(externalFile_.path));
+
+    externalFile_.saving = true;
+    dialog->toolBar()->invalidateOpenFiles();
+    dialog->toolBar()->updateButtons();
+
+    // write a snapshot of the buffer on a worker thread; QSaveFile writes
+    // to a temporary file and renames it over the target on commit():
+    QString path = externalFile_.path;
+    QByteArray data = utf8Text();
+    quint64 rev = revision_;
+    QPointer<Editor> self(this);
+    QThreadPool::globalInstance()->start([=] {
+        QString error;
+        QSaveFile f(path);
+        if(!f.open(QIODevice::WriteOnly))
+            error = f.errorString();
+        else if(f.write(data) != data.size())
+            error = f.errorString();
+        else if(!f.commit())
+            error = f.errorString();
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [=] {
+            if(self) self->onExternalFileSaved(path, rev, error);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void Editor::onExternalFileSaved(const QString &path, quint64 rev, const QString &error)
+{
+    externalFile_.saving = false;
+
+    if(error.isEmpty())
+    {
+        // the buffer may have been edited while the snapshot was being written:
+        // (edits reach all the views of a shared document at once, so the
+        // other views are in sync with this one)
+        if(path == externalFile_.path && rev == revision_)
+        {
+            // (a file created by saving is not registered yet: no other views)
+            externalFile_.edited = false;
+            for(auto editor : DocumentRegistry::instance()->editors(this))
+            {
+                if(editor == this) continue;
+                editor->externalFile_.edited = false;
+                editor->dialog->toolBar()->invalidateOpenFiles();
+                editor->dialog->toolBar()->updateButtons();
+            }
+            compactUndoHistory();
+        }
+        dialog->statusBar()->showMessage(QStringLiteral("File %1 saved.").arg(path), 4000);
+    }
+    else
+    {
+        // not modal: the save button shows the error, until the next save
+        sim::addLog(sim_verbosity_errors, "cannot write to file %s: %s", path.toStdString(), error.toStdString());
+        if(dialog->statusBar()->isVisible())
+            dialog->statusBar()->showMessage(QStringLiteral("Cannot write to file %1: %2").arg(path, error), 8000);
+    }
+    if(path == externalFile_.path)
+        externalFile_.saveError = error;
+
+    dialog->toolBar()->invalidateOpenFiles();
+    dialog->toolBar()->updateButtons();
 }
 
 QString Editor::externalFile()
@@ -755,6 +1345,131 @@ bool Editor::canSave()
     return !externalFile_.path.isEmpty();
 }
 
+bool Editor::findMatch(const SearchOptions &opts, bool forward, bool *wrapped)
+{
+    QByteArray text = documentBytes();
+    int from = SendScintilla(forward ? QsciScintillaBase::SCI_GETSELECTIONEND : QsciScintillaBase::SCI_GETSELECTIONSTART);
+    SearchMatch m;
+    bool wrap = false;
+    if(!::findNext(text, opts, from, forward, m))
+    {
+        if(!::findNext(text, opts, forward ? 0 : text.size(), forward, m)) return false;
+        wrap = true;
+    }
+    if(wrapped) *wrapped = wrap;
+    ensureLineVisible(m.line);
+    SendScintilla(QsciScintillaBase::SCI_SETSEL, (unsigned long)m.start, (long)(m.start + m.length));
+    return true;
+}
+
+bool Editor::replaceMatch(const SearchOptions &opts, const QString &replaceWith)
+{
+    if(isReadOnly()) return false;
+
+    int start = SendScintilla(QsciScintillaBase::SCI_GETSELECTIONSTART);
+    int end = SendScintilla(QsciScintillaBase::SCI_GETSELECTIONEND);
+    SearchMatch m;
+    QByteArray replacement;
+    if(!::findNext(documentBytes(), opts, start, true, m, replaceWith, &replacement)
+            || m.start != start || m.start + m.length != end)
+        return false;
+
+    SendScintilla(QsciScintillaBase::SCI_SETTARGETSTART, (int)start);
+    SendScintilla(QsciScintillaBase::SCI_SETTARGETEND, (int)end);
+    SendScintilla(QsciScintillaBase::SCI_REPLACETARGET, (unsigned long)replacement.size(), replacement.constData());
+    SendScintilla(QsciScintillaBase::SCI_GOTOPOS, (int)(start + replacement.size()));
+    return true;
+}
+
+int Editor::replaceAll(const SearchOptions &opts, const QString &replaceWith)
+{
+    if(isReadOnly()) return 0;
+
+    ReplaceResult r;
+    if(!::replaceAll(utf8Text(), opts, replaceWith, r)) return -1;
+    if(r.count == 0) return 0;
+
+    // apply everything as a single edit and a single undo action: scintilla
+    // notifies it as one deletion and one insertion
+    beginUndoAction();
+    SendScintilla(QsciScintillaBase::SCI_SETTARGETSTART, (int)r.from);
+    SendScintilla(QsciScintillaBase::SCI_SETTARGETEND, (int)r.to);
+    SendScintilla(QsciScintillaBase::SCI_REPLACETARGET, (unsigned long)r.text.size(), r.text.constData());
+    endUndoAction();
+    return r.count;
+}
+
+void Editor::setSearchMatches(const QVector<SearchMatch> &matches)
+{
+    searchMatches_.clear();
+    addSearchMatches(matches);
+}
+
+void Editor::addSearchMatches(const QVector<SearchMatch> &matches)
+{
+    for(const auto &m : matches)
+        searchMatches_.append(qMakePair(m.start, m.length));
+    markVisibleSearchMatches();
+}
+
+void Editor::markVisibleSearchMatches()
+{
+    // only the visible part of the document is marked, so that the cost
+    // does not depend on the total number of matches:
+    int length = SendScintilla(QsciScintillaBase::SCI_GETLENGTH);
+    SendScintilla(QsciScintillaBase::SCI_SETINDICATORCURRENT, (int)21);
+    int markedFrom = qMin(searchMatchesMarked_.first, length);
+    int markedTo = qMin(searchMatchesMarked_.second, length);
+    if(markedTo > markedFrom)
+        SendScintilla(QsciScintillaBase::SCI_INDICATORCLEARRANGE, (unsigned long)markedFrom, (long)(markedTo - markedFrom));
+    searchMatchesMarked_ = qMakePair(0, 0);
+    if(searchMatches_.isEmpty()) return;
+
+    int firstVisible = SendScintilla(QsciScintillaBase::SCI_GETFIRSTVISIBLELINE);
+    int linesOnScreen = SendScintilla(QsciScintillaBase::SCI_LINESONSCREEN);
+    int firstLine = SendScintilla(QsciScintillaBase::SCI_DOCLINEFROMVISIBLE, (unsigned long)firstVisible);
+    int lastLine = SendScintilla(QsciScintillaBase::SCI_DOCLINEFROMVISIBLE, (unsigned long)(firstVisible + linesOnScreen + 1));
+    int from = SendScintilla(QsciScintillaBase::SCI_POSITIONFROMLINE, (unsigned long)firstLine);
+    int to = SendScintilla(QsciScintillaBase::SCI_GETLINEENDPOSITION, (unsigned long)lastLine);
+
+    auto it = std::lower_bound(searchMatches_.cbegin(), searchMatches_.cend(), from, [] (const QPair<int, int> &m, int pos) {
+        return m.first + m.second < pos;
+    });
+    for(; it != searchMatches_.cend() && it->first <= to && it->first < length; ++it)
+    {
+        int n = qMin(it->second, length - it->first);
+        SendScintilla(QsciScintillaBase::SCI_INDICATORFILLRANGE, (unsigned long)it->first, (long)n);
+        from = qMin(from, it->first);
+        to = qMax(to, it->first + n);
+    }
+    searchMatchesMarked_ = qMakePair(from, to);
+}
+
+QByteArray Editor::utf8Text()
+{
+    // the bytes of the document itself (which is UTF-8), so that offsets in
+    // them are positions of scintilla:
+    int length = SendScintilla(QsciScintillaBase::SCI_GETLENGTH);
+    const char *data = reinterpret_cast<const char *>(SendScintillaPtrResult(QsciScintillaBase::SCI_GETCHARACTERPOINTER));
+    return QByteArray(data, length);
+}
+
+QByteArray Editor::documentBytes()
+{
+    // same as utf8Text, without a copy: only valid until the next edit
+    int length = SendScintilla(QsciScintillaBase::SCI_GETLENGTH);
+    const char *data = reinterpret_cast<const char *>(SendScintillaPtrResult(QsciScintillaBase::SCI_GETCHARACTERPOINTER));
+    return QByteArray::fromRawData(data, length);
+}
+
+DocumentSnapshot Editor::snapshot()
+{
+    DocumentSnapshot s;
+    s.text = utf8Text();
+    s.revision = revision_;
+    return s;
+}
+
 std::string Editor::divideString(const char* s) const
 {
     size_t w=80;
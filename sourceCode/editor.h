@@ -1,8 +1,18 @@
 #ifndef EDITOR_H
 #define EDITOR_H
 
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMenu>
+#include <QTimer>
+#include <memory>
 #include <Qsci/qsciscintilla.h>
 #include "common.h"
+#include "finder.h"
+#include "analysis.h"
+#include "syntaxcheck.h"
+#include "outline.h"
+#include "changetracker.h"
 
 class Dialog;
 
@@ -12,6 +22,7 @@ class Editor : public QsciScintilla
 
 public:
     Editor(Dialog *dialog);
+    virtual ~Editor();
     bool isActive() const;
     inline const EditorOptions & editorOptions() { return opts; }
     void setEditorOptions(const EditorOptions &opts);
@@ -21,6 +32,10 @@ public:
     int positionFromPoint(const QPoint &p);
     QString tokenAt(const QPoint &p);
 
+protected:
+    void keyPressEvent(QKeyEvent *event);
+    void paintEvent(QPaintEvent *event);
+
 public slots:
     void setText(const char* txt, int insertMode);
     void setAStyle(int style, QColor fore, QColor back, int size=-1, const char *face = nullptr, bool bold = false);
@@ -32,6 +47,8 @@ public slots:
     void onSelectionChanged();
     void indentSelectedText();
     void unindentSelectedText();
+    void onDwellStart(int position, int x, int y);
+    void onDwellEnd(int position, int x, int y);
     void openExternalFile(const QString &filePath);
     void saveExternalFile();
 
@@ -39,19 +56,73 @@ public:
     QString externalFile();
     bool needsSaving();
     bool canSave();
+    inline bool isSaving() const { return externalFile_.saving; }
+    inline const QString & saveError() const { return externalFile_.saveError; }
+    inline quint64 revision() const { return revision_; }
+    QByteArray utf8Text();
+    DocumentSnapshot snapshot();
+    // select the next (or previous) match after the selection, wrapping
+    // around the end of the document; false if there is none
+    bool findMatch(const SearchOptions &opts, bool forward, bool *wrapped = nullptr);
+    // replace the selection, if it is a match; false otherwise
+    bool replaceMatch(const SearchOptions &opts, const QString &replaceWith);
+    int replaceAll(const SearchOptions &opts, const QString &replaceWith);
+    void setSearchMatches(const QVector<SearchMatch> &matches);
+    void addSearchMatches(const QVector<SearchMatch> &matches);
+    inline bool isLargeFile() const { return largeFile_; }
+    inline bool isHugeFile() const { return hugeFile_; }
+    MemoryUsage memoryUsage();
+    EditorViewState viewState();
+    void setDiagnostics(const QVector<Diagnostic> &diagnostics);
+    inline const QVector<Diagnostic> & diagnostics() const { return diagnostics_; }
+    bool hasOutline() const;
+    inline const QVector<OutlineEntry> & outline() const { return outline_; }
+    void setChangeBaseline(const QString &text);
+    void compactUndoHistory();
+    void setViewState(const EditorViewState &state);
 
     inline EditorOptions options() const { return opts; }
 
 private:
     QString getCallTip(const QString &txt);
     std::string divideString(const char* s) const;
-    
+    void setFileSize(qint64 size);
+    void applyHugeFileMode();
+    void loadFile(QFile &f);
+    void onExternalFileSaved(const QString &path, quint64 rev, const QString &error);
+    void markVisibleSearchMatches();
+    QByteArray documentBytes();
+    bool undoLimitExceeded() const;
+    void checkSyntax();
+    void invalidateOutline(int line);
+    void updateLineChanges();
+    void setLineChanges(const QVector<LineChange> &changes);
+    void addGoToDefinitionActions(QMenu *menu, const QString &tok);
+
     Dialog *dialog;
     EditorOptions opts;
     struct {
         QString path;
-        bool edited;
+        bool edited {false};
+        bool saving {false};
+        QString saveError;  // of the last save, if it failed
     } externalFile_;
+    quint64 revision_ {0};
+    qint64 undoBytes_ {0};
+    int undoSteps_ {0};
+    std::shared_ptr<SyntaxChecker> syntaxChecker_;
+    QTimer *syntaxCheckTimer_;
+    QTimer *undoLimitTimer_;
+    QVector<Diagnostic> diagnostics_;
+    QVector<OutlineEntry> outline_;
+    StyleOutline styleOutline_;
+    std::unique_ptr<ChangeTracker> changeTracker_;
+    bool diagnosticTipShown_ {false};
+    QVector<QPair<int, int>> searchMatches_;
+    QPair<int, int> searchMatchesMarked_ {0, 0};
+    QElapsedTimer keyPressTime_;
+    bool largeFile_ {false};
+    bool hugeFile_ {false};
 };
 
 #endif // EDITOR_H
@@ -0,0 +1,367 @@
+#include "finder.h"
+#include <QDateTime>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QRegularExpression>
+#include <QSet>
+#include <algorithm>
+
+int utf8Length(const QChar *s, int n)
+{
+    int len = 0;
+    for(int i = 0; i < n; i++)
+    {
+        ushort c = s[i].unicode();
+        if(c < 0x80)
+            len += 1;
+        else if(c < 0x800)
+            len += 2;
+        else if(QChar::isHighSurrogate(c) && i + 1 < n && s[i + 1].isLowSurrogate())
+        {
+            len += 4;
+            i++;
+        }
+        else
+            len += 3;
+    }
+    return len;
+}
+
+static bool isAscii(const char *s, int n)
+{
+    for(int i = 0; i < n; i++)
+        if(static_cast<unsigned char>(s[i]) >= 0x80)
+            return false;
+    return true;
+}
+
+static bool makeRegExp(const SearchOptions &opts, QRegularExpression &re)
+{
+    if(!opts.regExp) return true;
+    re.setPattern(opts.what);
+    if(!opts.caseSensitive)
+        re.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
+    if(!re.isValid()) return false;
+    re.optimize();
+    return true;
+}
+
+bool findAll(const QByteArray &text, const SearchOptions &opts, const std::atomic<bool> &cancel, const std::function<void(const QVector<SearchMatch> &)> &onChunk)
+{
+    if(opts.what.isEmpty()) return false;
+
+    QRegularExpression re;
+    if(!makeRegExp(opts, re)) return false;
+    Qt::CaseSensitivity cs = opts.caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+
+    const int chunkLines = 4096;
+    const int previewLength = 200;
+    QVector<SearchMatch> chunk;
+    const char *data = text.constData();
+    int size = text.size();
+    int line = 0;
+
+    for(int lineStart = 0; lineStart < size; line++)
+    {
+        int lineEnd = text.indexOf('\n', lineStart);
+        if(lineEnd == -1) lineEnd = size;
+        int n = lineEnd - lineStart;
+        if(n > 0 && data[lineEnd - 1] == '\r') n--;
+
+        QString s = QString::fromUtf8(data + lineStart, n);
+        bool ascii = isAscii(data + lineStart, n);
+        auto addMatch = [&] (int from, int len) {
+            SearchMatch m;
+            m.line = line;
+            m.start = lineStart + (ascii ? from : utf8Length(s.constData(), from));
+            m.length = ascii ? len : utf8Length(s.constData() + from, len);
+            m.preview = s.trimmed().left(previewLength);
+            chunk.append(m);
+        };
+
+        if(opts.regExp)
+        {
+            auto i = re.globalMatch(s);
+            while(i.hasNext())
+            {
+                auto m = i.next();
+                if(m.capturedLength() > 0)
+                    addMatch(m.capturedStart(), m.capturedLength());
+            }
+        }
+        else
+        {
+            for(int from = s.indexOf(opts.what, 0, cs); from != -1; from = s.indexOf(opts.what, from + opts.what.length(), cs))
+                addMatch(from, opts.what.length());
+        }
+
+        lineStart = lineEnd + 1;
+
+        if((line + 1) % chunkLines == 0)
+        {
+            if(cancel) return false;
+            if(!chunk.isEmpty())
+            {
+                onChunk(chunk);
+                chunk.clear();
+            }
+        }
+    }
+
+    if(cancel) return false;
+    if(!chunk.isEmpty())
+        onChunk(chunk);
+    return true;
+}
+
+static QString expandReplacement(const QString &replaceWith, const QRegularExpressionMatch &m)
+{
+    QString ret;
+    ret.reserve(replaceWith.size());
+    for(int i = 0; i < replaceWith.size(); i++)
+    {
+        QChar c = replaceWith[i];
+        if(c == '\\' && i + 1 < replaceWith.size())
+        {
+            QChar d = replaceWith[i + 1];
+            if(d.isDigit())
+            {
+                ret += m.captured(d.digitValue());
+                i++;
+                continue;
+            }
+            if(d == '\\')
+            {
+                ret += d;
+                i++;
+                continue;
+            }
+        }
+        ret += c;
+    }
+    return ret;
+}
+
+bool replaceAll(const QByteArray &text, const SearchOptions &opts, const QString &replaceWith, ReplaceResult &result)
+{
+    result.from = 0;
+    result.to = 0;
+    result.text.clear();
+    result.count = 0;
+
+    if(opts.what.isEmpty()) return false;
+
+    QRegularExpression re;
+    if(!makeRegExp(opts, re)) return false;
+    Qt::CaseSensitivity cs = opts.caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+
+    const char *data = text.constData();
+    int size = text.size();
+    int firstChanged = -1, lastChanged = -1;
+
+    for(int lineStart = 0; lineStart < size; )
+    {
+        int lineEnd = text.indexOf('\n', lineStart);
+        if(lineEnd == -1) lineEnd = size;
+        int n = lineEnd - lineStart;
+        if(n > 0 && data[lineEnd - 1] == '\r') n--;
+
+        QString s = QString::fromUtf8(data + lineStart, n);
+        QString out;
+        int copied = 0, count = 0;
+
+        if(opts.regExp)
+        {
+            auto i = re.globalMatch(s);
+            while(i.hasNext())
+            {
+                auto m = i.next();
+                if(m.capturedLength() == 0) continue;
+                out.append(s.constData() + copied, m.capturedStart() - copied);
+                out += expandReplacement(replaceWith, m);
+                copied = m.capturedEnd();
+                count++;
+            }
+        }
+        else
+        {
+            for(int from = s.indexOf(opts.what, 0, cs); from != -1; from = s.indexOf(opts.what, copied, cs))
+            {
+                out.append(s.constData() + copied, from - copied);
+                out += replaceWith;
+                copied = from + opts.what.length();
+                count++;
+            }
+        }
+
+        if(count)
+        {
+            out.append(s.constData() + copied, s.size() - copied);
+            if(firstChanged == -1)
+                firstChanged = lineStart;
+            else // copy the unchanged lines in between verbatim:
+                result.text.append(data + lastChanged, lineStart - lastChanged);
+            result.text.append(out.toUtf8());
+            lastChanged = lineStart + n;
+            result.count += count;
+        }
+
+        lineStart = lineEnd + 1;
+    }
+
+    if(result.count)
+    {
+        result.from = firstChanged;
+        result.to = lastChanged;
+    }
+    return true;
+}
+
+bool findNext(const QByteArray &text, const SearchOptions &opts, int from, bool forward, SearchMatch &match, const QString &replaceWith, QByteArray *replacement)
+{
+    if(opts.what.isEmpty()) return false;
+
+    QRegularExpression re;
+    if(!makeRegExp(opts, re)) return false;
+    Qt::CaseSensitivity cs = opts.caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+
+    const char *data = text.constData();
+    const int size = text.size();
+    from = qBound(0, from, size);
+    int lineStart = from > 0 ? text.lastIndexOf('\n', from - 1) + 1 : 0;
+    int line = int(std::count(data, data + lineStart, '\n'));
+
+    for(;;)
+    {
+        int lineEnd = text.indexOf('\n', lineStart);
+        if(lineEnd == -1) lineEnd = size;
+        int n = lineEnd - lineStart;
+        if(n > 0 && data[lineEnd - 1] == '\r') n--;
+
+        QString s = QString::fromUtf8(data + lineStart, n);
+        bool ascii = isAscii(data + lineStart, n);
+        bool found = false;
+        // forward, the first match starting at or after from; backward,
+        // the last one ending at or before from (returns true when done):
+        auto take = [&] (int start, int length, const QRegularExpressionMatch *m) {
+            int b = lineStart + (ascii ? start : utf8Length(s.constData(), start));
+            int len = ascii ? length : utf8Length(s.constData() + start, length);
+            if(forward ? b < from : b + len > from) return !forward;
+            match.line = line;
+            match.start = b;
+            match.length = len;
+            match.preview = s.trimmed().left(200);
+            if(replacement)
+                *replacement = (m ? expandReplacement(replaceWith, *m) : replaceWith).toUtf8();
+            found = true;
+            return forward;
+        };
+
+        if(opts.regExp)
+        {
+            auto i = re.globalMatch(s);
+            while(i.hasNext())
+            {
+                auto m = i.next();
+                if(m.capturedLength() > 0 && take(m.capturedStart(), m.capturedLength(), &m))
+                    break;
+            }
+        }
+        else
+        {
+            for(int i = s.indexOf(opts.what, 0, cs); i != -1; i = s.indexOf(opts.what, i + opts.what.length(), cs))
+                if(take(i, opts.what.length(), nullptr))
+                    break;
+        }
+        if(found) return true;
+
+        if(forward)
+        {
+            if(lineEnd >= size) return false;
+            lineStart = lineEnd + 1;
+            line++;
+        }
+        else
+        {
+            if(lineStart == 0) return false;
+            lineStart = lineStart >= 2 ? text.lastIndexOf('\n', lineStart - 2) + 1 : 0;
+            line--;
+        }
+    }
+}
+
+struct FileSearchCacheEntry
+{
+    QDateTime lastModified;
+    qint64 size;
+    SearchOptions opts;
+    QVector<SearchMatch> matches;
+};
+
+static QMutex fileSearchCacheMutex;
+static QHash<QString, FileSearchCacheEntry> fileSearchCache;
+
+bool findAllInFile(const QString &path, const SearchOptions &opts, const std::atomic<bool> &cancel, QVector<SearchMatch> &matches, qint64 maxSize)
+{
+    QFileInfo info(path);
+    if(!info.isFile()) return false;
+    if(maxSize >= 0 && info.size() > maxSize) return false;
+
+    {
+        QMutexLocker locker(&fileSearchCacheMutex);
+        auto it = fileSearchCache.constFind(path);
+        if(it != fileSearchCache.constEnd() && it->lastModified == info.lastModified() && it->size == info.size() && it->opts == opts)
+        {
+            matches = it->matches;
+            return true;
+        }
+    }
+
+    QFile f(path);
+    if(!f.open(QIODevice::ReadOnly)) return false;
+    QByteArray text = f.readAll();
+    f.close();
+
+    QVector<SearchMatch> result;
+    if(!findAll(text, opts, cancel, [&] (const QVector<SearchMatch> &chunk) { result += chunk; }))
+        return false;
+
+    {
+        QMutexLocker locker(&fileSearchCacheMutex);
+        fileSearchCache[path] = {info.lastModified(), info.size(), opts, result};
+    }
+    matches = result;
+    return true;
+}
+
+QStringList scriptSearchPathFiles(const QVector<QString> &scriptSearchPath)
+{
+    QStringList files;
+    QSet<QString> seen;
+    for(const auto &pattern : scriptSearchPath)
+    {
+        int q = pattern.indexOf('?');
+        if(q == -1) continue;
+        int slash = pattern.lastIndexOf('/', q);
+        if(slash == -1) continue;
+        QString dir = pattern.left(slash);
+        QString suffix = pattern.mid(q + 1);
+        if(dir.isEmpty() || seen.contains(dir + "\n" + suffix)) continue;
+        seen.insert(dir + "\n" + suffix);
+
+        QDirIterator it(dir, QDir::Files | QDir::Readable, QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+        while(it.hasNext())
+        {
+            QString file = QDir::cleanPath(it.next());
+            if(file.endsWith(suffix) && !seen.contains(file))
+            {
+                seen.insert(file);
+                files << file;
+            }
+        }
+    }
+    return files;
+}
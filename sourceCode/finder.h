@@ -0,0 +1,70 @@
+#ifndef FINDER_H
+#define FINDER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <atomic>
+#include <functional>
+
+struct SearchOptions
+{
+    QString what;
+    bool regExp {false};
+    bool caseSensitive {false};
+
+    inline bool operator==(const SearchOptions &o) const
+    {
+        return what == o.what && regExp == o.regExp && caseSensitive == o.caseSensitive;
+    }
+};
+
+struct SearchMatch
+{
+    int line;       // 0-based line number
+    int start;      // byte offset of the match in the (UTF-8) document
+    int length;     // length of the match in bytes
+    QString preview;
+};
+
+struct ReplaceResult
+{
+    int from;           // byte range of the original document
+    int to;             // covered by the rewritten text
+    QByteArray text;
+    int count;
+};
+
+int utf8Length(const QChar *s, int n);
+
+// scan a UTF-8 document line by line for all occurrences of opts.what.
+// matches are reported in chunks through onChunk, so that callers can
+// stream them to the UI while the scan is still running.
+// returns false if the search was cancelled or the pattern is not valid.
+bool findAll(const QByteArray &text, const SearchOptions &opts, const std::atomic<bool> &cancel, const std::function<void(const QVector<SearchMatch> &)> &onChunk);
+
+// compute the replacement of all occurrences of opts.what in one pass.
+// the result is a single edit spanning from the first to the last match,
+// so that it can be applied as one target replacement. for regular
+// expressions, \0 .. \9 in replaceWith are expanded to captured groups.
+// returns false if the pattern is not valid.
+bool replaceAll(const QByteArray &text, const SearchOptions &opts, const QString &replaceWith, ReplaceResult &result);
+
+// find the first occurrence of opts.what starting at byte offset from or,
+// if not forward, the last one ending at or before from (without wrapping
+// around), line by line and with the same regular expressions as findAll.
+// if replacement is given, it is set to the (UTF-8) text replacing the
+// match, expanded as in replaceAll.
+// returns false if there is none or the pattern is not valid.
+bool findNext(const QByteArray &text, const SearchOptions &opts, int from, bool forward, SearchMatch &match, const QString &replaceWith = QString(), QByteArray *replacement = nullptr);
+
+// same as findAll, but for a file on disk. results are cached per file
+// and reused as long as the file's modification time and size are unchanged.
+bool findAllInFile(const QString &path, const SearchOptions &opts, const std::atomic<bool> &cancel, QVector<SearchMatch> &matches, qint64 maxSize = -1);
+
+// list the files matched by the patterns of EditorOptions::scriptSearchPath
+// (e.g. "/path/to/lua/?.lua" yields all the *.lua files under /path/to/lua)
+QStringList scriptSearchPathFiles(const QVector<QString> &scriptSearchPath);
+
+#endif // FINDER_H
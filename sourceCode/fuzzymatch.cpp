@@ -0,0 +1,196 @@
+#include "fuzzymatch.h"
+#include <algorithm>
+#include <climits>
+#include <utility>
+
+namespace {
+
+// characters of longer candidates after this are not considered
+const int maxScoredLength = 256;
+
+const int noMatch = INT_MIN / 2;
+
+// score of a matched character:
+const int matchScore = 16;
+const int firstCharBonus = 12;      // first character of the candidate
+const int wordStartBonus = 10;      // after a separator, or a camelCase hump
+const int consecutiveBonus = 8;     // right after the previous match
+const int gapPenalty = 1;           // per skipped character between matches
+
+inline char fold(char c)
+{
+    return c >= 'A' && c <= 'Z' ? char(c + 'a' - 'A') : c;
+}
+
+inline quint64 charBit(char c)
+{
+    unsigned char u = (unsigned char)c;
+    if(u >= 'a' && u <= 'z') return quint64(1) << (u - 'a');
+    if(u >= '0' && u <= '9') return quint64(1) << (26 + u - '0');
+    if(u == '_') return quint64(1) << 36;
+    if(u == '.') return quint64(1) << 37;
+    if(u == ':') return quint64(1) << 38;
+    if(u == '/') return quint64(1) << 39;
+    return quint64(1) << (40 + u % 24);
+}
+
+// mask of the (folded) characters of s
+inline quint64 charMask(const char *s, int n)
+{
+    quint64 m = 0;
+    for(int i = 0; i < n; i++)
+        m |= charBit(s[i]);
+    return m;
+}
+
+inline bool isSeparator(char c)
+{
+    return c == '_' || c == '.' || c == ':' || c == '/' || c == '\\' || c == ' ' || c == '-' || c == '(';
+}
+
+} // namespace
+
+void FuzzyIndex::clear()
+{
+    text_.clear();
+    folded_.clear();
+    offsets_.clear();
+    masks_.clear();
+}
+
+void FuzzyIndex::reserve(int count, int bytes)
+{
+    text_.reserve(bytes);
+    folded_.reserve(bytes);
+    offsets_.reserve(count + 1);
+    masks_.reserve(count);
+}
+
+int FuzzyIndex::add(const QString &text)
+{
+    if(offsets_.isEmpty()) offsets_.append(0);
+    QByteArray utf8 = text.toUtf8();
+    int start = folded_.size();
+    text_ += utf8;
+    for(char c : utf8)
+        folded_ += fold(c);
+    offsets_.append(folded_.size());
+    masks_.append(charMask(folded_.constData() + start, utf8.size()));
+    return masks_.size() - 1;
+}
+
+QString FuzzyIndex::text(int i) const
+{
+    return QString::fromUtf8(text_.constData() + offsets_[i], offsets_[i + 1] - offsets_[i]);
+}
+
+QVector<int> FuzzyIndex::match(const QString &query, int limit) const
+{
+    QVector<int> result;
+    QByteArray q;
+    for(char c : query.toUtf8())
+        if(c != ' ') q += fold(c);
+    if(q.isEmpty())
+    {
+        for(int i = 0; i < size() && i < limit; i++)
+            result.append(i);
+        return result;
+    }
+
+    // prefilter, without branches: the test is unpredictable for short
+    // queries, so every index is written and only the kept ones are
+    // skipped past (it is not vectorized, but takes the same time whatever
+    // the number of candidates kept)
+    const quint64 qmask = charMask(q.constData(), q.size());
+    const quint64 *masks = masks_.constData();
+    const int n = masks_.size();
+    QVector<int> candidates(n);
+    int *out = candidates.data();
+    int count = 0;
+    for(int i = 0; i < n; i++)
+    {
+        out[count] = i;
+        count += (masks[i] & qmask) == qmask;
+    }
+
+    QVector<std::pair<int, int>> scored; // (-score, index), so that sorting puts the best first
+    scored.reserve(count);
+    for(int k = 0; k < count; k++)
+    {
+        const int i = out[k];
+        int s = score(i, q.constData(), q.size());
+        if(s > noMatch) scored.append({-s, i});
+    }
+    const int best = std::min(limit, int(scored.size()));
+    std::partial_sort(scored.begin(), scored.begin() + best, scored.end());
+    for(int i = 0; i < best; i++)
+        result.append(scored[i].second);
+    return result;
+}
+
+int FuzzyIndex::score(int k, const char *q, int m) const
+{
+    const char *c = folded_.constData() + offsets_[k];
+    const char *orig = text_.constData() + offsets_[k];
+    const int length = offsets_[k + 1] - offsets_[k];
+    const int n = std::min(length, maxScoredLength);
+    if(n < m) return noMatch;
+
+    // the j-th query character can only be matched between its earliest
+    // (greedy from the start) and its latest (greedy from the end) position:
+    int lo[maxScoredLength], hi[maxScoredLength];
+    for(int i = 0, j = 0; j < m; i++, j++)
+    {
+        while(i < n && c[i] != q[j]) i++;
+        if(i == n) return noMatch;
+        lo[j] = i;
+    }
+    for(int i = n - 1, j = m - 1; j >= 0; i--, j--)
+    {
+        while(c[i] != q[j]) i--;
+        hi[j] = i;
+    }
+
+    int bonus[maxScoredLength];
+    for(int i = lo[0]; i <= hi[m - 1]; i++)
+    {
+        bonus[i] = matchScore;
+        if(i == 0)
+            bonus[i] += firstCharBonus;
+        else if(isSeparator(orig[i - 1]) || (orig[i - 1] >= 'a' && orig[i - 1] <= 'z' && orig[i] >= 'A' && orig[i] <= 'Z'))
+            bonus[i] += wordStartBonus;
+    }
+
+    // prev[i] / cur[i]: best score of matching the query up to the
+    // previous / current character, with that character matched at c[i]
+    int prev[maxScoredLength], cur[maxScoredLength];
+    for(int i = lo[0]; i <= hi[0]; i++)
+        prev[i] = c[i] == q[0] ? bonus[i] - std::min(i, 3) * gapPenalty : noMatch;
+    for(int j = 1; j < m; j++)
+    {
+        // gap: best of prev[p] - gapPenalty * (i - 1 - p) for p < i - 1
+        int gap = noMatch;
+        for(int p = lo[j - 1]; p < lo[j] - 1 && p <= hi[j - 1]; p++)
+            if(prev[p] > noMatch)
+                gap = std::max(gap, prev[p] - (lo[j] - 1 - p) * gapPenalty);
+        for(int i = lo[j]; i <= hi[j]; i++)
+        {
+            int before = i - 1 <= hi[j - 1] ? prev[i - 1] : noMatch;
+            int s = noMatch;
+            if(c[i] == q[j])
+            {
+                int best = std::max(gap, before > noMatch ? before + consecutiveBonus : noMatch);
+                if(best > noMatch) s = bonus[i] + best;
+            }
+            cur[i] = s;
+            gap = std::max(gap, before) - gapPenalty;
+        }
+        std::copy(cur + lo[j], cur + hi[j] + 1, prev + lo[j]);
+    }
+
+    int best = noMatch;
+    for(int i = lo[m - 1]; i <= hi[m - 1]; i++)
+        best = std::max(best, prev[i]);
+    // among equal matches, prefer the shorter candidates:
+    return best > noMatch ? best - length / 8 : noMatch;
+}
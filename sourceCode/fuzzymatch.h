@@ -0,0 +1,35 @@
+#ifndef FUZZYMATCH_H
+#define FUZZYMATCH_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+// candidate strings for fuzzy (subsequence) matching. the strings are
+// stored back to back in one buffer, with a 64 bit mask per candidate of
+// the characters it contains: a query first discards the candidates
+// missing any of its characters with a single pass over the masks, and
+// only scores the remaining ones.
+class FuzzyIndex
+{
+public:
+    void clear();
+    void reserve(int count, int bytes);
+    int add(const QString &text);
+    inline int size() const { return masks_.size(); }
+    QString text(int i) const;
+
+    // indices of the best matches of query (at most limit), best first;
+    // all the candidates (up to limit) in order if query is empty
+    QVector<int> match(const QString &query, int limit) const;
+
+private:
+    int score(int i, const char *query, int queryLength) const;
+
+    QByteArray text_;       // UTF-8
+    QByteArray folded_;     // same, with ASCII lowercased
+    QVector<int> offsets_;  // size() + 1
+    QVector<quint64> masks_;
+};
+
+#endif // FUZZYMATCH_H
@@ -0,0 +1,85 @@
+#include "idlescheduler.h"
+#include "editor.h"
+#include "stats.h"
+#include <QTimer>
+#include <QElapsedTimer>
+
+IdleScheduler * IdleScheduler::instance()
+{
+    static thread_local IdleScheduler *scheduler = nullptr;
+    if(!scheduler) scheduler = new IdleScheduler;
+    return scheduler;
+}
+
+IdleScheduler::IdleScheduler()
+{
+    // a zero timer fires once all the pending events have been processed:
+    timer_ = new QTimer(this);
+    timer_->setSingleShot(true);
+    timer_->setInterval(0);
+    connect(timer_, &QTimer::timeout, this, &IdleScheduler::runSlice);
+}
+
+void IdleScheduler::post(QObject *owner, const QString &key, Priority priority, Editor *editor, const Step &step)
+{
+    cancel(owner, key);
+
+    Task task;
+    task.owner = owner;
+    task.key = key;
+    task.priority = priority;
+    task.bound = editor != nullptr;
+    task.editor = editor;
+    task.revision = editor ? editor->revision() : 0;
+    task.step = step;
+    enqueue(task, false);
+}
+
+void IdleScheduler::enqueue(const Task &task, bool first)
+{
+    // keep tasks sorted by priority; a task being resumed goes before the
+    // others of the same priority, a new one after them:
+    int i = 0;
+    while(i < tasks_.size() && (tasks_[i].priority < task.priority || (!first && tasks_[i].priority == task.priority)))
+        i++;
+    tasks_.insert(i, task);
+
+    if(!timer_->isActive())
+        timer_->start();
+}
+
+void IdleScheduler::cancel(QObject *owner, const QString &key)
+{
+    for(int i = tasks_.size() - 1; i >= 0; i--)
+        if(tasks_[i].owner == owner && tasks_[i].key == key)
+            tasks_.removeAt(i);
+}
+
+bool IdleScheduler::isPending(QObject *owner, const QString &key) const
+{
+    for(const auto &task : tasks_)
+        if(task.owner == owner && task.key == key)
+            return true;
+    return false;
+}
+
+void IdleScheduler::runSlice()
+{
+    STATS_SCOPE("IdleScheduler::runSlice");
+
+    QElapsedTimer t;
+    t.start();
+    while(!tasks_.isEmpty() && t.elapsed() < budgetMs_)
+    {
+        Task task = tasks_.takeFirst();
+        if(!task.owner) continue;
+        if(task.bound && (!task.editor || task.editor->revision() != task.revision)) continue;
+
+        // the step may post a replacement of itself, which wins:
+        if(task.step() && task.owner && !isPending(task.owner, task.key))
+            enqueue(task, true);
+    }
+
+    if(!tasks_.isEmpty())
+        timer_->start();
+}
@@ -0,0 +1,64 @@
+#ifndef IDLESCHEDULER_H
+#define IDLESCHEDULER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QList>
+#include <functional>
+
+class QTimer;
+class Editor;
+
+// cooperative scheduler for background work of the UI thread (one per
+// thread). tasks run when the event loop is idle, highest priority first,
+// for at most budget() ms per event loop iteration; a task returns true
+// from its step function if it has more work left, and is stepped again
+// in a later slice. a task bound to an editor is dropped as soon as the
+// editor's revision differs from the one at the time it was posted.
+class IdleScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Priority
+    {
+        High,
+        Normal,
+        Low
+    };
+
+    using Step = std::function<bool()>;
+
+    static IdleScheduler * instance();
+
+    // post a task; a pending task with the same owner and key is replaced
+    void post(QObject *owner, const QString &key, Priority priority, Editor *editor, const Step &step);
+    void cancel(QObject *owner, const QString &key);
+    bool isPending(QObject *owner, const QString &key) const;
+
+    inline int budget() const { return budgetMs_; }
+    inline void setBudget(int ms) { budgetMs_ = ms; }
+
+private:
+    IdleScheduler();
+    void runSlice();
+
+    struct Task
+    {
+        QPointer<QObject> owner;
+        QString key;
+        Priority priority;
+        bool bound;
+        QPointer<Editor> editor;
+        quint64 revision;
+        Step step;
+    };
+    void enqueue(const Task &task, bool first);
+
+    QList<Task> tasks_;
+    QTimer *timer_;
+    int budgetMs_ {8};
+};
+
+#endif // IDLESCHEDULER_H
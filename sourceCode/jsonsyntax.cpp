@@ -0,0 +1,426 @@
+#include "jsonsyntax.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// minimum distance between two checkpoints
+const int checkpointInterval = 32768;
+
+// objects and arrays nested deeper than this are not in the outline
+const int outlineDepth = 3;
+
+struct SyntaxError
+{
+    int start;
+    int end;
+    int line;
+    QString message;
+};
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline bool isHexDigit(char c)
+{
+    return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+bool sameState(const JsonSyntaxChecker::State &a, const JsonSyntaxChecker::State &b)
+{
+    if(a.expect != b.expect || a.stack.size() != b.stack.size()) return false;
+    for(int i = a.stack.size() - 1; i >= 0; i--)
+    {
+        const auto &x = a.stack[i], &y = b.stack[i];
+        if(x.object != y.object || x.index != y.index || x.key != y.key)
+            return false;
+    }
+    return true;
+}
+
+class Scanner
+{
+public:
+    using State = JsonSyntaxChecker::State;
+
+    Scanner(const QByteArray &text, State &state, QVector<OutlineEntry> &outline)
+        : s(text.constData()), n(text.size()), st(state), outline(outline)
+    {
+    }
+
+    // scan until the end of the text, or until stop(state) returns true
+    // (called before each token); returns true if stopped
+    template<typename Stop>
+    bool run(QVector<State> &checkpoints, Stop stop)
+    {
+        int next = checkpoints.isEmpty() ? 0 : checkpoints.last().pos + checkpointInterval;
+        while(true)
+        {
+            skipSpace();
+            st.outlineCount = outline.size();
+            if(stop(st)) return true;
+            if(st.pos >= next)
+            {
+                checkpoints.append(st);
+                next = st.pos + checkpointInterval;
+            }
+            if(st.pos >= n) break;
+            token();
+        }
+        if(!st.stack.isEmpty())
+        {
+            const auto &f = st.stack.last();
+            error(f.openPos, f.openPos + 1, f.openLine, QStringLiteral("'%1' was never closed").arg(f.object ? '{' : '['));
+        }
+        return false;
+    }
+
+private:
+    [[noreturn]] void error(int start, int end, int line, const QString &message)
+    {
+        throw SyntaxError {start, end, line, message};
+    }
+
+    [[noreturn]] void unexpected(const QString &expected)
+    {
+        int end = st.pos + 1;
+        while(end < n && (s[end] & 0xC0) == 0x80) end++;
+        error(st.pos, end, st.line, "unexpected '" + QString::fromUtf8(s + st.pos, end - st.pos) + "', expected " + expected);
+    }
+
+    void skipSpace()
+    {
+        while(st.pos < n)
+        {
+            char c = s[st.pos];
+            if(c == ' ' || c == '\t')
+                st.pos++;
+            else if(isNewline(c))
+            {
+                st.pos = skipNewline(s, n, st.pos);
+                st.line++;
+            }
+            else break;
+        }
+    }
+
+    void token()
+    {
+        char c = s[st.pos];
+        switch(st.expect)
+        {
+        case JsonSyntaxChecker::Value:
+        case JsonSyntaxChecker::ValueOrClose:
+            if(c == ']' && st.expect == JsonSyntaxChecker::ValueOrClose)
+                close();
+            else
+                value();
+            break;
+        case JsonSyntaxChecker::Key:
+        case JsonSyntaxChecker::KeyOrClose:
+            if(c == '}' && st.expect == JsonSyntaxChecker::KeyOrClose)
+                close();
+            else if(c == '"')
+            {
+                auto &f = st.stack.last();
+                int start = st.pos;
+                string();
+                f.key = QByteArray(s + start + 1, st.pos - start - 2);
+                f.keyPos = start;
+                f.keyLine = st.line;
+                st.expect = JsonSyntaxChecker::Colon;
+            }
+            else
+                unexpected(st.expect == JsonSyntaxChecker::Key ? QStringLiteral("a key") : QStringLiteral("a key or '}'"));
+            break;
+        case JsonSyntaxChecker::Colon:
+            if(c != ':')
+                unexpected(QStringLiteral("':'"));
+            st.pos++;
+            st.expect = JsonSyntaxChecker::Value;
+            break;
+        case JsonSyntaxChecker::CommaOrClose:
+            if(c == ',')
+            {
+                st.pos++;
+                st.expect = st.stack.last().object ? JsonSyntaxChecker::Key : JsonSyntaxChecker::Value;
+            }
+            else if(c == (st.stack.last().object ? '}' : ']'))
+                close();
+            else
+                unexpected(st.stack.last().object ? QStringLiteral("',' or '}'") : QStringLiteral("',' or ']'"));
+            break;
+        case JsonSyntaxChecker::End:
+            unexpected(QStringLiteral("end of document"));
+        }
+    }
+
+    void value()
+    {
+        char c = s[st.pos];
+        if(!st.stack.isEmpty() && !st.stack.last().object)
+            st.stack.last().index++;
+        if(c == '{' || c == '[')
+        {
+            if(!st.stack.isEmpty() && st.stack.size() <= outlineDepth)
+                outline.append({path(), st.stack.last().object ? st.stack.last().keyLine : st.line});
+            JsonSyntaxChecker::Frame f;
+            f.object = c == '{';
+            f.index = -1;
+            f.keyPos = -1;
+            f.keyLine = -1;
+            f.openPos = st.pos++;
+            f.openLine = st.line;
+            st.stack.append(f);
+            st.expect = f.object ? JsonSyntaxChecker::KeyOrClose : JsonSyntaxChecker::ValueOrClose;
+            return;
+        }
+        if(c == '"')
+            string();
+        else if(c == '-' || isDigit(c))
+            number();
+        else if(!literal("true") && !literal("false") && !literal("null"))
+            unexpected(st.expect == JsonSyntaxChecker::ValueOrClose ? QStringLiteral("a value or ']'") : QStringLiteral("a value"));
+        afterValue();
+    }
+
+    void afterValue()
+    {
+        st.expect = st.stack.isEmpty() ? JsonSyntaxChecker::End : JsonSyntaxChecker::CommaOrClose;
+    }
+
+    void close()
+    {
+        st.pos++;
+        st.stack.removeLast();
+        afterValue();
+    }
+
+    bool literal(const char *word)
+    {
+        int len = int(std::strlen(word));
+        if(n - st.pos < len || std::memcmp(s + st.pos, word, len) != 0) return false;
+        if(st.pos + len < n && ((s[st.pos + len] | 0x20) >= 'a' && (s[st.pos + len] | 0x20) <= 'z')) return false;
+        st.pos += len;
+        return true;
+    }
+
+    void number()
+    {
+        int start = st.pos, p = st.pos;
+        auto digits = [&] {
+            int d = p;
+            while(p < n && isDigit(s[p])) p++;
+            return p > d;
+        };
+        bool ok = true;
+        if(s[p] == '-') p++;
+        if(p < n && s[p] == '0') p++;
+        else ok = digits();
+        if(ok && p < n && s[p] == '.')
+        {
+            p++;
+            ok = digits();
+        }
+        if(ok && p < n && (s[p] == 'e' || s[p] == 'E'))
+        {
+            p++;
+            if(p < n && (s[p] == '+' || s[p] == '-')) p++;
+            ok = digits();
+        }
+        // include what follows, if it looks like part of the number:
+        int end = p;
+        while(end < n && (isDigit(s[end]) || s[end] == '.' || (s[end] | 0x20) == 'e' || s[end] == '+' || s[end] == '-' || (s[end] | 0x20) == 'x'))
+            end++;
+        if(!ok || end != p)
+            error(start, end, st.line, "invalid number '" + QString::fromUtf8(s + start, end - start) + "'");
+        st.pos = p;
+    }
+
+    void string()
+    {
+        int start = st.pos++;
+        while(true)
+        {
+            if(st.pos >= n || isNewline(s[st.pos]))
+                error(start, st.pos, st.line, QStringLiteral("unterminated string"));
+            unsigned char c = s[st.pos];
+            if(c == '"')
+            {
+                st.pos++;
+                return;
+            }
+            if(c < 0x20)
+                error(st.pos, st.pos + 1, st.line, QStringLiteral("control character in string"));
+            if(c == '\\')
+            {
+                int esc = st.pos++;
+                if(st.pos >= n || isNewline(s[st.pos]))
+                    continue;
+                c = s[st.pos++];
+                if(c == 'u')
+                {
+                    for(int k = 0; k < 4; k++, st.pos++)
+                        if(st.pos >= n || !isHexDigit(s[st.pos]))
+                            error(esc, st.pos, st.line, QStringLiteral("invalid unicode escape sequence"));
+                }
+                else if(!std::strchr("\"\\/bfnrt", c))
+                    error(esc, st.pos, st.line, QStringLiteral("invalid escape sequence"));
+            }
+            else st.pos++;
+        }
+    }
+
+    // key path of the value about to start, e.g. "objects[2].pose"
+    QString path() const
+    {
+        QByteArray p;
+        for(const auto &f : st.stack)
+        {
+            if(f.object)
+            {
+                if(!p.isEmpty()) p += '.';
+                p += f.key;
+            }
+            else
+            {
+                p += '[';
+                p += QByteArray::number(f.index);
+                p += ']';
+            }
+        }
+        return QString::fromUtf8(p);
+    }
+
+    const char *s;
+    int n;
+    State &st;
+    QVector<OutlineEntry> &outline;
+};
+
+} // namespace
+
+QVector<Diagnostic> JsonSyntaxChecker::check(const QByteArray &text)
+{
+    const int oldSize = text_.size(), newSize = text.size();
+    int prefix = 0, suffix = 0;
+    {
+        const char *a = text_.constData(), *b = text.constData();
+        int m = std::min(oldSize, newSize);
+        const int block = 64;
+        while(prefix + block <= m && std::memcmp(a + prefix, b + prefix, block) == 0) prefix += block;
+        while(prefix < m && a[prefix] == b[prefix]) prefix++;
+        if(prefix == oldSize && oldSize == newSize && !checkpoints_.isEmpty())
+            return diagnostics_;
+        while(suffix + block <= m - prefix && std::memcmp(a + oldSize - suffix - block, b + newSize - suffix - block, block) == 0) suffix += block;
+        while(suffix < m - prefix && a[oldSize - 1 - suffix] == b[newSize - 1 - suffix]) suffix++;
+    }
+    const int delta = newSize - oldSize;
+
+    // resume from the last checkpoint before the first changed byte (the
+    // byte at the checkpoint must be unchanged too, as it ends the token
+    // before it):
+    int keep = 0;
+    while(keep < checkpoints_.size() && checkpoints_[keep].pos < prefix) keep++;
+    const QVector<State> old = checkpoints_.mid(keep);
+    const QVector<OutlineEntry> oldOutline = outline_;
+    const QVector<Diagnostic> oldDiagnostics = diagnostics_;
+    checkpoints_.resize(keep);
+
+    State state;
+    if(checkpoints_.isEmpty())
+    {
+        state.pos = 0;
+        state.line = 0;
+        state.expect = Value;
+        state.outlineCount = 0;
+        outline_.clear();
+    }
+    else
+    {
+        state = checkpoints_.takeLast();
+        outline_.resize(state.outlineCount);
+    }
+    diagnostics_.clear();
+
+    // only the checkpoints in the unchanged tail can be resynchronized with:
+    int o = 0;
+    while(o < old.size() && old[o].pos < oldSize - suffix) o++;
+
+    try
+    {
+        Scanner scanner(text, state, outline_);
+        bool resynced = scanner.run(checkpoints_, [&] (const State &s) {
+            while(o < old.size() && old[o].pos + delta < s.pos) o++;
+            return o < old.size() && old[o].pos + delta == s.pos && sameState(old[o], s);
+        });
+        if(resynced)
+        {
+            // from here on, the result is the one of the previous scan, shifted:
+            const int lineDelta = state.line - old[o].line;
+            const int outlineDelta = outline_.size() - old[o].outlineCount;
+            const State &sync = old[o];
+            auto shift = [&] (int &pos, int &line) {
+                if(pos >= oldSize - suffix)
+                {
+                    pos += delta;
+                    line += lineDelta;
+                    return;
+                }
+                // positions before the tail can only be the ones of the
+                // enclosing objects and arrays, which may have moved:
+                for(int i = 0; i < sync.stack.size(); i++)
+                {
+                    if(pos == sync.stack[i].openPos)
+                    {
+                        pos = state.stack[i].openPos;
+                        line = state.stack[i].openLine;
+                        return;
+                    }
+                    if(pos == sync.stack[i].keyPos)
+                    {
+                        pos = state.stack[i].keyPos;
+                        line = state.stack[i].keyLine;
+                        return;
+                    }
+                }
+            };
+            for(int i = o; i < old.size(); i++)
+            {
+                State c = old[i];
+                shift(c.pos, c.line);
+                c.outlineCount += outlineDelta;
+                for(auto &f : c.stack)
+                {
+                    shift(f.openPos, f.openLine);
+                    if(f.keyPos >= 0) shift(f.keyPos, f.keyLine);
+                }
+                checkpoints_.append(c);
+            }
+            for(int i = old[o].outlineCount; i < oldOutline.size(); i++)
+            {
+                OutlineEntry e = oldOutline[i];
+                e.line += lineDelta;
+                outline_.append(e);
+            }
+            for(Diagnostic d : oldDiagnostics)
+            {
+                shift(d.start, d.line);
+                diagnostics_.append(d);
+            }
+        }
+    }
+    catch(SyntaxError &e)
+    {
+        Diagnostic d;
+        d.start = e.start;
+        d.length = e.end - e.start;
+        d.line = e.line;
+        d.message = e.message;
+        diagnostics_.append(d);
+    }
+    text_ = text;
+    return diagnostics_;
+}
@@ -0,0 +1,60 @@
+#ifndef JSONSYNTAX_H
+#define JSONSYNTAX_H
+
+#include "syntaxcheck.h"
+
+// streaming (SAX-style) JSON validator, reporting the first error, which
+// also builds an outline of the key paths of the objects and arrays. the
+// state of the scanner is saved every few KB; after an edit, scanning
+// resumes from the last checkpoint before the change, and stops as soon
+// as it is back in the same state at a checkpoint of the previous scan
+// after the change, so that editing a large document is not rescanning it.
+class JsonSyntaxChecker : public SyntaxChecker
+{
+public:
+    bool providesOutline() const override { return true; }
+    bool supportsHugeFiles() const override { return true; }
+
+    enum Expect
+    {
+        Value,          // a value (document start, after ':' or after ',' in an array)
+        ValueOrClose,   // after '['
+        Key,            // after ',' in an object
+        KeyOrClose,     // after '{'
+        Colon,
+        CommaOrClose,   // after a value in an object or array
+        End             // after the top level value
+    };
+
+    struct Frame
+    {
+        bool object;
+        int index;      // of the current element, for arrays
+        QByteArray key; // of the current member, for objects (as written)
+        int keyPos;
+        int keyLine;
+        int openPos;
+        int openLine;
+    };
+
+    struct State
+    {
+        int pos;
+        int line;
+        Expect expect;
+        QVector<Frame> stack;
+        int outlineCount;   // outline entries before pos
+    };
+
+protected:
+    QVector<Diagnostic> check(const QByteArray &text) override;
+    QVector<OutlineEntry> outline() const override { return outline_; }
+
+private:
+    QByteArray text_;
+    QVector<State> checkpoints_;
+    QVector<OutlineEntry> outline_;
+    QVector<Diagnostic> diagnostics_;
+};
+
+#endif // JSONSYNTAX_H
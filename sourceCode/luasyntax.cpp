@@ -0,0 +1,1166 @@
+#include "luasyntax.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+enum Tok
+{
+    T_EOF, T_NAME, T_NUMBER, T_STRING, T_CHAR,
+    // reserved words:
+    T_AND, T_BREAK, T_DO, T_ELSE, T_ELSEIF, T_END, T_FALSE, T_FOR, T_FUNCTION,
+    T_GOTO, T_IF, T_IN, T_LOCAL, T_NIL, T_NOT, T_OR, T_REPEAT, T_RETURN,
+    T_THEN, T_TRUE, T_UNTIL, T_WHILE,
+    // multi-character operators:
+    T_IDIV, T_CONCAT, T_DOTS, T_EQ, T_GE, T_LE, T_NE, T_SHL, T_SHR, T_DBCOLON
+};
+
+const char *reservedWords[] = {
+    "and", "break", "do", "else", "elseif", "end", "false", "for", "function",
+    "goto", "if", "in", "local", "nil", "not", "or", "repeat", "return",
+    "then", "true", "until", "while",
+    "//", "..", "...", "==", ">=", "<=", "~=", "<<", ">>", "::"
+};
+
+struct Token
+{
+    Tok type;
+    char ch;        // for T_CHAR
+    int start;
+    int end;
+    int line;
+};
+
+struct SyntaxError
+{
+    int start;
+    int end;
+    int line;
+    int openLine;
+    QString message;
+    QString messageTail;
+};
+
+inline bool isNameStart(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline bool isNameChar(char c)
+{
+    return isNameStart(c) || isDigit(c);
+}
+
+inline bool isHexDigit(char c)
+{
+    return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+// level of the long bracket ([[, [=[, ...) at i, or -1
+inline int longBracketLevel(const char *s, int n, int i)
+{
+    int j = i + 1;
+    while(j < n && s[j] == '=') j++;
+    return j < n && s[j] == '[' ? j - i - 1 : -1;
+}
+
+Tok reservedWord(const char *s, int len)
+{
+    if(len < 2 || len > 8 || s[0] < 'a' || s[0] > 'w') return T_NAME;
+    for(int i = 0; i <= T_WHILE - T_AND; i++)
+        if(int(std::strlen(reservedWords[i])) == len && std::memcmp(reservedWords[i], s, len) == 0)
+            return Tok(T_AND + i);
+    return T_NAME;
+}
+
+class Lexer
+{
+public:
+    Lexer(const char *data, int size, int pos, int line)
+        : s(data), n(size), p(pos), line(line)
+    {
+    }
+
+    Token next()
+    {
+        for(;;)
+        {
+            Token t;
+            t.type = T_CHAR;
+            t.ch = 0;
+            t.start = p;
+            t.line = line;
+            if(p >= n)
+            {
+                t.type = T_EOF;
+                t.end = p;
+                return t;
+            }
+            char c = s[p];
+            switch(c)
+            {
+            case '\n':
+            case '\r':
+                p = skipNewline(s, n, p);
+                line++;
+                continue;
+            case ' ':
+            case '\t':
+            case '\f':
+            case '\v':
+                p++;
+                continue;
+            case '-':
+                if(p + 1 < n && s[p + 1] == '-')
+                {
+                    p += 2;
+                    int level = p < n && s[p] == '[' ? longBracketLevel(s, n, p) : -1;
+                    if(level >= 0)
+                        readLongString(t, level, true);
+                    else
+                        while(p < n && !isNewline(s[p])) p++;
+                    continue;
+                }
+                return single(t);
+            case '[':
+                {
+                    int level = longBracketLevel(s, n, p);
+                    if(level < 0) return single(t);
+                    readLongString(t, level, false);
+                    t.type = T_STRING;
+                    t.end = p;
+                    return t;
+                }
+            case '=':
+                return pair(t, '=', T_EQ);
+            case '<':
+                if(p + 1 < n && s[p + 1] == '<') return pair(t, '<', T_SHL);
+                return pair(t, '=', T_LE);
+            case '>':
+                if(p + 1 < n && s[p + 1] == '>') return pair(t, '>', T_SHR);
+                return pair(t, '=', T_GE);
+            case '/':
+                return pair(t, '/', T_IDIV);
+            case '~':
+                return pair(t, '=', T_NE);
+            case ':':
+                return pair(t, ':', T_DBCOLON);
+            case '"':
+            case '\'':
+                readString(t);
+                return t;
+            case '.':
+                if(p + 1 < n && s[p + 1] == '.')
+                {
+                    if(p + 2 < n && s[p + 2] == '.')
+                    {
+                        t.type = T_DOTS;
+                        p += 3;
+                    }
+                    else
+                    {
+                        t.type = T_CONCAT;
+                        p += 2;
+                    }
+                    t.end = p;
+                    return t;
+                }
+                if(p + 1 < n && isDigit(s[p + 1]))
+                {
+                    readNumber(t);
+                    return t;
+                }
+                return single(t);
+            default:
+                if(isDigit(c))
+                {
+                    readNumber(t);
+                    return t;
+                }
+                if(isNameStart(c))
+                {
+                    while(p < n && isNameChar(s[p])) p++;
+                    t.type = reservedWord(s + t.start, p - t.start);
+                    t.end = p;
+                    return t;
+                }
+                return single(t);
+            }
+        }
+    }
+
+    QString text(const Token &t) const
+    {
+        if(t.type == T_EOF) return QStringLiteral("<eof>");
+        int len = t.end - t.start;
+        if(len > 40) return "'" + QString::fromUtf8(s + t.start, 40) + "...'";
+        return "'" + QString::fromUtf8(s + t.start, len) + "'";
+    }
+
+private:
+    Token & single(Token &t)
+    {
+        t.ch = s[p++];
+        t.end = p;
+        return t;
+    }
+
+    Token & pair(Token &t, char second, Tok type)
+    {
+        if(p + 1 < n && s[p + 1] == second)
+        {
+            t.type = type;
+            p += 2;
+            t.end = p;
+            return t;
+        }
+        return single(t);
+    }
+
+    [[noreturn]] void error(const Token &t, const QString &message)
+    {
+        SyntaxError e;
+        e.start = t.start;
+        e.end = p;
+        e.line = t.line;
+        e.openLine = -1;
+        Token partial = t;
+        partial.end = p;
+        e.message = message + " near " + (p >= n ? QStringLiteral("<eof>") : text(partial));
+        throw e;
+    }
+
+    void readLongString(Token &t, int level, bool comment)
+    {
+        p += level + 2;
+        if(p < n && isNewline(s[p]))
+        {
+            p = skipNewline(s, n, p);
+            line++;
+        }
+        for(;;)
+        {
+            if(p >= n)
+                error(t, comment ? QStringLiteral("unfinished long comment") : QStringLiteral("unfinished long string"));
+            char c = s[p];
+            if(c == ']')
+            {
+                int j = p + 1;
+                while(j < n && s[j] == '=') j++;
+                if(j < n && s[j] == ']' && j - p - 1 == level)
+                {
+                    p = j + 1;
+                    return;
+                }
+                p++;
+            }
+            else if(isNewline(c))
+            {
+                p = skipNewline(s, n, p);
+                line++;
+            }
+            else p++;
+        }
+    }
+
+    void readString(Token &t)
+    {
+        char quote = s[p++];
+        for(;;)
+        {
+            if(p >= n || isNewline(s[p]))
+                error(t, QStringLiteral("unfinished string"));
+            char c = s[p];
+            if(c == quote)
+            {
+                p++;
+                break;
+            }
+            if(c != '\\')
+            {
+                p++;
+                continue;
+            }
+            p++;
+            if(p >= n) continue;
+            c = s[p];
+            if(isNewline(c))
+            {
+                p = skipNewline(s, n, p);
+                line++;
+            }
+            else if(c == 'x')
+            {
+                p++;
+                for(int i = 0; i < 2; i++, p++)
+                    if(p >= n || !isHexDigit(s[p]))
+                        error(t, QStringLiteral("hexadecimal digit expected"));
+            }
+            else if(c == 'z')
+            {
+                p++;
+                while(p < n && (s[p] == ' ' || s[p] == '\t' || s[p] == '\f' || s[p] == '\v' || isNewline(s[p])))
+                {
+                    if(isNewline(s[p]))
+                    {
+                        p = skipNewline(s, n, p);
+                        line++;
+                    }
+                    else p++;
+                }
+            }
+            else if(c == 'u')
+            {
+                p++;
+                if(p >= n || s[p] != '{')
+                    error(t, QStringLiteral("missing '{' in \\u{xxxx}"));
+                p++;
+                int digits = 0;
+                while(p < n && isHexDigit(s[p])) p++, digits++;
+                if(!digits)
+                    error(t, QStringLiteral("hexadecimal digit expected"));
+                if(p >= n || s[p] != '}')
+                    error(t, QStringLiteral("missing '}' in \\u{xxxx}"));
+                p++;
+            }
+            else if(isDigit(c))
+            {
+                int value = 0;
+                for(int i = 0; i < 3 && p < n && isDigit(s[p]); i++, p++)
+                    value = 10 * value + s[p] - '0';
+                if(value > 255)
+                    error(t, QStringLiteral("decimal escape too large"));
+            }
+            else if(std::strchr("abfnrtv\\\"'", c))
+                p++;
+            else
+            {
+                p++;
+                error(t, QStringLiteral("invalid escape sequence"));
+            }
+        }
+        t.type = T_STRING;
+        t.end = p;
+    }
+
+    void readNumber(Token &t)
+    {
+        const char *exponent = "Ee";
+        bool hex = false;
+        if(s[p] == '0' && p + 1 < n && (s[p + 1] == 'x' || s[p + 1] == 'X'))
+        {
+            p += 2;
+            exponent = "Pp";
+            hex = true;
+        }
+        for(;;)
+        {
+            if(p < n && s[p] && std::strchr(exponent, s[p]))
+            {
+                p++;
+                if(p < n && (s[p] == '+' || s[p] == '-')) p++;
+            }
+            else if(p < n && (isHexDigit(s[p]) || s[p] == '.'))
+                p++;
+            else break;
+        }
+        // a letter glued to the numeral makes it malformed:
+        while(p < n && isNameChar(s[p])) p++;
+        t.type = T_NUMBER;
+        t.end = p;
+        if(!validNumber(s + t.start + (hex ? 2 : 0), p - t.start - (hex ? 2 : 0), hex))
+            error(t, QStringLiteral("malformed number"));
+    }
+
+    static bool validNumber(const char *d, int len, bool hex)
+    {
+        int i = 0, digits = 0;
+        auto isMantissaDigit = [hex](char c) { return hex ? isHexDigit(c) : isDigit(c); };
+        while(i < len && isMantissaDigit(d[i])) i++, digits++;
+        if(i < len && d[i] == '.')
+        {
+            i++;
+            while(i < len && isMantissaDigit(d[i])) i++, digits++;
+        }
+        if(!digits) return false;
+        if(i < len && std::strchr(hex ? "Pp" : "Ee", d[i]))
+        {
+            i++;
+            if(i < len && (d[i] == '+' || d[i] == '-')) i++;
+            int expDigits = 0;
+            while(i < len && isDigit(d[i])) i++, expDigits++;
+            if(!expDigits) return false;
+        }
+        return i == len;
+    }
+
+    const char *s;
+    int n;
+    int p;
+
+public:
+    int line;
+};
+
+// recursive descent parser following the structure of lparser.c
+class Parser
+{
+public:
+    Parser(const char *data, int size, int pos, int line, const QVector<int> &chunkStarts)
+        : lex(data, size, pos, line),
+          chunkStarts(chunkStarts)
+    {
+    }
+
+    // parse top-level statements until the next one starts a chunk; returns
+    // the index of that chunk, or chunkStarts.size() at the end of the text
+    int parseChunks()
+    {
+        varargs.append(true);
+        next();
+        for(;;)
+        {
+            if(t.type == T_EOF)
+                return chunkStarts.size();
+            if(t.type == T_RETURN)
+            {
+                retstat();
+                if(t.type != T_EOF)
+                    errorExpected("'<eof>'");
+                return chunkStarts.size();
+            }
+            if(blockFollow(true))
+                errorExpected("'<eof>'");
+            statement();
+            int chunk = chunkAt(t.start);
+            if(chunk >= 0)
+                return chunk;
+        }
+    }
+
+private:
+    enum ExpKind
+    {
+        K_VAR,
+        K_CALL,
+        K_OTHER
+    };
+
+    int chunkAt(int pos) const
+    {
+        auto it = std::lower_bound(chunkStarts.begin(), chunkStarts.end(), pos);
+        return it != chunkStarts.end() && *it == pos ? int(it - chunkStarts.begin()) : -1;
+    }
+
+    void next()
+    {
+        if(hasAhead)
+        {
+            t = ahead;
+            hasAhead = false;
+        }
+        else t = lex.next();
+    }
+
+    const Token & peek()
+    {
+        if(!hasAhead)
+        {
+            ahead = lex.next();
+            hasAhead = true;
+        }
+        return ahead;
+    }
+
+    inline bool isChar(char c) const
+    {
+        return t.type == T_CHAR && t.ch == c;
+    }
+
+    bool testNext(Tok type)
+    {
+        if(t.type != type) return false;
+        next();
+        return true;
+    }
+
+    bool testNextChar(char c)
+    {
+        if(!isChar(c)) return false;
+        next();
+        return true;
+    }
+
+    static QString quoted(Tok type)
+    {
+        return "'" + QString::fromUtf8(reservedWords[type - T_AND]) + "'";
+    }
+
+    static QString quoted(char c)
+    {
+        return "'" + QString(QChar(c)) + "'";
+    }
+
+    [[noreturn]] void error(const QString &message)
+    {
+        SyntaxError e;
+        e.start = t.start;
+        e.end = t.end;
+        e.line = t.line;
+        e.openLine = -1;
+        e.message = message + " near " + lex.text(t);
+        throw e;
+    }
+
+    // error not about the current token (luaK_semerror)
+    [[noreturn]] void semanticError(const QString &message)
+    {
+        SyntaxError e;
+        e.start = t.start;
+        e.end = t.end;
+        e.line = t.line;
+        e.openLine = -1;
+        e.message = message;
+        throw e;
+    }
+
+    [[noreturn]] void errorExpected(const QString &what)
+    {
+        error(what + " expected");
+    }
+
+    void checkNext(Tok type)
+    {
+        if(!testNext(type)) errorExpected(quoted(type));
+    }
+
+    void checkNextChar(char c)
+    {
+        if(!testNextChar(c)) errorExpected(quoted(c));
+    }
+
+    void checkName()
+    {
+        if(t.type != T_NAME) errorExpected("<name>");
+        next();
+    }
+
+    // expect the token closing a construct opened by who at line
+    template<typename What, typename Who>
+    void checkMatch(What what, bool matched, Who who, int line)
+    {
+        if(matched) return;
+        if(line == t.line)
+            errorExpected(quoted(what));
+        SyntaxError e;
+        e.start = t.start;
+        e.end = t.end;
+        e.line = t.line;
+        e.openLine = line;
+        e.message = quoted(what) + " expected (to close " + quoted(who) + " at line ";
+        e.messageTail = ") near " + lex.text(t);
+        throw e;
+    }
+
+    void enterLevel()
+    {
+        if(++depth > 200) error(QStringLiteral("chunk has too many syntax levels"));
+    }
+
+    void leaveLevel()
+    {
+        depth--;
+    }
+
+    bool blockFollow(bool withUntil) const
+    {
+        switch(t.type)
+        {
+        case T_ELSE:
+        case T_ELSEIF:
+        case T_END:
+        case T_EOF:
+            return true;
+        case T_UNTIL:
+            return withUntil;
+        default:
+            return false;
+        }
+    }
+
+    void block()
+    {
+        while(!blockFollow(true))
+        {
+            if(t.type == T_RETURN)
+            {
+                retstat();
+                return;
+            }
+            statement();
+        }
+    }
+
+    void retstat()
+    {
+        next();
+        if(!blockFollow(true) && !isChar(';'))
+            explist();
+        testNextChar(';');
+    }
+
+    void statement()
+    {
+        int line = t.line;
+        enterLevel();
+        switch(t.type)
+        {
+        case T_IF:
+            ifstat(line);
+            break;
+        case T_WHILE:
+            next();
+            expr();
+            checkNext(T_DO);
+            loops++;
+            block();
+            loops--;
+            checkMatch(T_END, testNext(T_END), T_WHILE, line);
+            break;
+        case T_DO:
+            next();
+            block();
+            checkMatch(T_END, testNext(T_END), T_DO, line);
+            break;
+        case T_FOR:
+            forstat(line);
+            break;
+        case T_REPEAT:
+            next();
+            loops++;
+            block();
+            loops--;
+            checkMatch(T_UNTIL, testNext(T_UNTIL), T_REPEAT, line);
+            expr();
+            break;
+        case T_FUNCTION:
+            next();
+            checkName();
+            while(testNextChar('.'))
+                checkName();
+            if(testNextChar(':'))
+                checkName();
+            body(line);
+            break;
+        case T_LOCAL:
+            next();
+            if(testNext(T_FUNCTION))
+            {
+                checkName();
+                body(line);
+            }
+            else localstat();
+            break;
+        case T_DBCOLON:
+            next();
+            checkName();
+            checkNext(T_DBCOLON);
+            break;
+        case T_BREAK:
+            if(!loops)
+                semanticError("break outside a loop at line " + QString::number(t.line + 1));
+            next();
+            break;
+        case T_GOTO:
+            next();
+            checkName();
+            break;
+        default:
+            if(isChar(';'))
+                next();
+            else
+                exprstat();
+            break;
+        }
+        leaveLevel();
+    }
+
+    void ifstat(int line)
+    {
+        do
+        {
+            next();
+            expr();
+            checkNext(T_THEN);
+            block();
+        }
+        while(t.type == T_ELSEIF);
+        if(testNext(T_ELSE))
+            block();
+        checkMatch(T_END, testNext(T_END), T_IF, line);
+    }
+
+    void forstat(int line)
+    {
+        next();
+        checkName();
+        if(testNextChar('='))
+        {
+            expr();
+            checkNextChar(',');
+            expr();
+            if(testNextChar(','))
+                expr();
+        }
+        else if(isChar(',') || t.type == T_IN)
+        {
+            while(testNextChar(','))
+                checkName();
+            checkNext(T_IN);
+            explist();
+        }
+        else error(QStringLiteral("'=' or 'in' expected"));
+        checkNext(T_DO);
+        loops++;
+        block();
+        loops--;
+        checkMatch(T_END, testNext(T_END), T_FOR, line);
+    }
+
+    void localstat()
+    {
+        do
+        {
+            checkName();
+            if(testNextChar('<'))
+            {
+                if(t.type == T_NAME)
+                {
+                    QString attr = lex.text(t);
+                    if(attr != "'const'" && attr != "'close'")
+                        semanticError("unknown attribute " + attr);
+                }
+                checkName();
+                checkNextChar('>');
+            }
+        }
+        while(testNextChar(','));
+        if(testNextChar('='))
+            explist();
+    }
+
+    void exprstat()
+    {
+        ExpKind kind = suffixedexp();
+        if(isChar('=') || isChar(','))
+        {
+            if(kind != K_VAR) error(QStringLiteral("syntax error"));
+            while(testNextChar(','))
+                if(suffixedexp() != K_VAR)
+                    error(QStringLiteral("syntax error"));
+            checkNextChar('=');
+            explist();
+        }
+        else if(kind != K_CALL)
+            error(QStringLiteral("syntax error"));
+    }
+
+    void body(int line)
+    {
+        checkNextChar('(');
+        bool vararg = false;
+        if(!isChar(')'))
+        {
+            do
+            {
+                if(t.type == T_NAME)
+                    next();
+                else if(t.type == T_DOTS)
+                {
+                    next();
+                    vararg = true;
+                    break;
+                }
+                else errorExpected("<name>");
+            }
+            while(testNextChar(','));
+        }
+        checkNextChar(')');
+        varargs.append(vararg);
+        int outerLoops = loops;
+        loops = 0;
+        block();
+        loops = outerLoops;
+        varargs.removeLast();
+        checkMatch(T_END, testNext(T_END), T_FUNCTION, line);
+    }
+
+    void explist()
+    {
+        expr();
+        while(testNextChar(','))
+            expr();
+    }
+
+    ExpKind primaryexp()
+    {
+        if(t.type == T_NAME)
+        {
+            next();
+            return K_VAR;
+        }
+        if(isChar('('))
+        {
+            int line = t.line;
+            next();
+            expr();
+            checkMatch(')', testNextChar(')'), '(', line);
+            return K_OTHER;
+        }
+        error(QStringLiteral("unexpected symbol"));
+    }
+
+    ExpKind suffixedexp()
+    {
+        ExpKind kind = primaryexp();
+        for(;;)
+        {
+            if(t.type == T_STRING)
+            {
+                next();
+                kind = K_CALL;
+            }
+            else if(t.type != T_CHAR)
+                return kind;
+            else if(t.ch == '.')
+            {
+                next();
+                checkName();
+                kind = K_VAR;
+            }
+            else if(t.ch == '[')
+            {
+                next();
+                expr();
+                checkNextChar(']');
+                kind = K_VAR;
+            }
+            else if(t.ch == ':')
+            {
+                next();
+                checkName();
+                funcargs();
+                kind = K_CALL;
+            }
+            else if(t.ch == '(' || t.ch == '{')
+            {
+                funcargs();
+                kind = K_CALL;
+            }
+            else return kind;
+        }
+    }
+
+    void funcargs()
+    {
+        if(isChar('('))
+        {
+            int line = t.line;
+            next();
+            if(!isChar(')'))
+                explist();
+            checkMatch(')', testNextChar(')'), '(', line);
+        }
+        else if(isChar('{'))
+            constructor();
+        else if(t.type == T_STRING)
+            next();
+        else error(QStringLiteral("function arguments expected"));
+    }
+
+    void constructor()
+    {
+        int line = t.line;
+        checkNextChar('{');
+        do
+        {
+            if(isChar('}')) break;
+            if(t.type == T_NAME && peek().type == T_CHAR && peek().ch == '=')
+            {
+                next();
+                next();
+                expr();
+            }
+            else if(isChar('['))
+            {
+                next();
+                expr();
+                checkNextChar(']');
+                checkNextChar('=');
+                expr();
+            }
+            else expr();
+        }
+        while(testNextChar(',') || testNextChar(';'));
+        checkMatch('}', testNextChar('}'), '{', line);
+    }
+
+    void simpleexp()
+    {
+        switch(t.type)
+        {
+        case T_NUMBER:
+        case T_STRING:
+        case T_NIL:
+        case T_TRUE:
+        case T_FALSE:
+            next();
+            return;
+        case T_DOTS:
+            if(!varargs.last())
+                error(QStringLiteral("cannot use '...' outside a vararg function"));
+            next();
+            return;
+        case T_FUNCTION:
+            {
+                int line = t.line;
+                next();
+                body(line);
+                return;
+            }
+        default:
+            if(isChar('{'))
+                constructor();
+            else
+                suffixedexp();
+        }
+    }
+
+    // left and right priority of the binary operator at t, or 0
+    bool binaryOp(int &left, int &right) const
+    {
+        switch(t.type)
+        {
+        case T_OR: left = right = 1; return true;
+        case T_AND: left = right = 2; return true;
+        case T_EQ: case T_NE: case T_LE: case T_GE: left = right = 3; return true;
+        case T_CONCAT: left = 9; right = 8; return true;
+        case T_SHL: case T_SHR: left = right = 7; return true;
+        case T_IDIV: left = right = 11; return true;
+        case T_CHAR:
+            switch(t.ch)
+            {
+            case '<': case '>': left = right = 3; return true;
+            case '|': left = right = 4; return true;
+            case '~': left = right = 5; return true;
+            case '&': left = right = 6; return true;
+            case '+': case '-': left = right = 10; return true;
+            case '*': case '/': case '%': left = right = 11; return true;
+            case '^': left = 14; right = 13; return true;
+            }
+            return false;
+        default:
+            return false;
+        }
+    }
+
+    void expr(int limit = 0)
+    {
+        enterLevel();
+        if(t.type == T_NOT || isChar('-') || isChar('#') || isChar('~'))
+        {
+            next();
+            expr(12);
+        }
+        else simpleexp();
+        int left, right;
+        while(binaryOp(left, right) && left > limit)
+        {
+            next();
+            expr(right);
+        }
+        leaveLevel();
+    }
+
+    Lexer lex;
+    const QVector<int> &chunkStarts;
+    Token t;
+    Token ahead;
+    bool hasAhead {false};
+    int depth {0};
+    int loops {0};
+    QVector<bool> varargs;
+};
+
+const char *continuationWords[] = {"end", "else", "elseif", "until", "then", "do", "in", "and", "or"};
+
+// offsets and lines of the top-level chunks: lines which start with a name
+// in the first column, outside of long strings and comments
+void splitChunks(const char *s, int n, QVector<int> &starts, QVector<int> &lines)
+{
+    starts.append(0);
+    lines.append(0);
+    int line = 0;
+    int i = 0;
+    auto newline = [&] {
+        i = skipNewline(s, n, i);
+        line++;
+        if(i >= n || !isNameStart(s[i])) return;
+        int j = i;
+        while(j < n && isNameChar(s[j])) j++;
+        for(const char *w : continuationWords)
+            if(int(std::strlen(w)) == j - i && std::memcmp(w, s + i, j - i) == 0)
+                return;
+        starts.append(i);
+        lines.append(line);
+    };
+    auto skipLongBracket = [&] (int level) {
+        i += level + 2;
+        while(i < n)
+        {
+            if(s[i] == ']')
+            {
+                int j = i + 1;
+                while(j < n && s[j] == '=') j++;
+                if(j < n && s[j] == ']' && j - i - 1 == level)
+                {
+                    i = j + 1;
+                    return;
+                }
+                i++;
+            }
+            else if(isNewline(s[i]))
+            {
+                i = skipNewline(s, n, i);
+                line++;
+            }
+            else i++;
+        }
+    };
+    while(i < n)
+    {
+        char c = s[i];
+        if(isNewline(c))
+            newline();
+        else if(c == '-' && i + 1 < n && s[i + 1] == '-')
+        {
+            i += 2;
+            int level = i < n && s[i] == '[' ? longBracketLevel(s, n, i) : -1;
+            if(level >= 0)
+                skipLongBracket(level);
+            else
+                while(i < n && !isNewline(s[i])) i++;
+        }
+        else if(c == '[')
+        {
+            int level = longBracketLevel(s, n, i);
+            if(level >= 0)
+                skipLongBracket(level);
+            else
+                i++;
+        }
+        else if(c == '"' || c == '\'')
+        {
+            i++;
+            while(i < n && s[i] != c && !isNewline(s[i]))
+            {
+                if(s[i] == '\\' && i + 1 < n)
+                {
+                    i++;
+                    if(isNewline(s[i]))
+                    {
+                        i = skipNewline(s, n, i);
+                        line++;
+                        continue;
+                    }
+                }
+                i++;
+            }
+            if(i < n && s[i] == c) i++;
+        }
+        else i++;
+    }
+}
+
+} // namespace
+
+QVector<Diagnostic> LuaSyntaxChecker::check(const QByteArray &text)
+{
+    const char *s = text.constData();
+    int n = text.size();
+
+    QVector<int> starts, lines;
+    splitChunks(s, n, starts, lines);
+    int count = starts.size();
+    QVector<size_t> hashes(count);
+    for(int i = 0; i < count; i++)
+    {
+        int end = i + 1 < count ? starts[i + 1] : n;
+        hashes[i] = chunkHash(s + starts[i], end - starts[i]);
+    }
+    auto groupHash = [&] (int first, int chunks) {
+        size_t h = 0;
+        for(int i = first; i < first + chunks; i++)
+            h = h * 31 + hashes[i];
+        return h;
+    };
+
+    QVector<Diagnostic> diagnostics;
+    QHash<size_t, Result> cache;
+    int i = 0;
+    while(i < count)
+    {
+        Result r;
+        auto it = cache_.constFind(hashes[i]);
+        bool hit = it != cache_.constEnd()
+            && i + it->chunks <= count
+            && it->atEnd == (i + it->chunks == count)
+            && it->hash == groupHash(i, it->chunks);
+        if(hit)
+            r = *it;
+        else
+        {
+            r.ok = true;
+            r.openLine = -1;
+            try
+            {
+                Parser parser(s, n, starts[i], lines[i], starts);
+                r.chunks = parser.parseChunks() - i;
+            }
+            catch(SyntaxError &e)
+            {
+                // the group ends with the chunk containing the error:
+                int last = int(std::upper_bound(starts.begin(), starts.end(), e.start) - starts.begin()) - 1;
+                r.chunks = qMax(1, last - i + 1);
+                r.ok = false;
+                r.errorStart = e.start - starts[i];
+                r.errorLength = e.end - e.start;
+                r.errorLine = e.line - lines[i];
+                r.openLine = e.openLine >= 0 ? e.openLine - lines[i] : -1;
+                r.message = e.message;
+                r.messageTail = e.messageTail;
+            }
+            r.atEnd = i + r.chunks == count;
+            r.hash = groupHash(i, r.chunks);
+        }
+        cache.insert(hashes[i], r);
+
+        if(!r.ok)
+        {
+            Diagnostic d;
+            d.start = starts[i] + r.errorStart;
+            d.length = r.errorLength;
+            d.line = lines[i] + r.errorLine;
+            d.message = r.openLine < 0 ? r.message : r.message + QString::number(lines[i] + r.openLine + 1) + r.messageTail;
+            diagnostics.append(d);
+        }
+        i += r.chunks;
+    }
+    cache_ = cache;
+    return diagnostics;
+}
@@ -0,0 +1,36 @@
+#ifndef LUASYNTAX_H
+#define LUASYNTAX_H
+
+#include <QHash>
+
+#include "syntaxcheck.h"
+
+// Lua 5.4 syntax checker (lexer and recursive descent parser, reporting
+// errors the way luac does). the document is split in top-level chunks,
+// i.e. at lines starting a statement in the first column; a group of
+// chunks that parsed to the same result before is not parsed again.
+class LuaSyntaxChecker : public SyntaxChecker
+{
+protected:
+    QVector<Diagnostic> check(const QByteArray &text) override;
+
+public:
+    struct Result
+    {
+        int chunks;             // number of chunks covered
+        size_t hash;            // hash of the text of the covered chunks
+        bool atEnd;             // the last covered chunk is the last one
+        bool ok;
+        int errorStart;         // relative to the first chunk
+        int errorLength;
+        int errorLine;          // relative to the first chunk
+        int openLine;           // relative line of the unclosed block, or -1
+        QString message;        // followed by the line of openLine, if any,
+        QString messageTail;    // and by messageTail
+    };
+
+private:
+    QHash<size_t, Result> cache_;
+};
+
+#endif // LUASYNTAX_H
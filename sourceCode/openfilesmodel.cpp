@@ -0,0 +1,109 @@
+#include "openfilesmodel.h"
+#include "editor.h"
+
+OpenFilesModel::OpenFilesModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int OpenFilesModel::rowCount(const QModelIndex &parent) const
+{
+    if(parent.isValid()) return 0;
+    return items_.size();
+}
+
+QVariant OpenFilesModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.row() >= items_.size()) return {};
+
+    const Item &item = items_[index.row()];
+    switch(role)
+    {
+    case Qt::DisplayRole:
+        {
+            QString name = item.name;
+            if(item.modified) name = "* " + name;
+            if(item.saving) name += " (saving...)";
+            return name;
+        }
+    case Qt::ToolTipRole:
+        return item.name;
+    case Qt::UserRole:
+        return item.path;
+    }
+    return {};
+}
+
+void OpenFilesModel::sync(const QMap<QString, Editor*> &editors, const QMap<QString, EditorViewState> &unloadedFiles)
+{
+    // merge the (sorted, disjoint) keys of the two maps against the rows:
+    int row = 0;
+    auto e = editors.constBegin();
+    auto u = unloadedFiles.constBegin();
+    while(e != editors.constEnd() || u != unloadedFiles.constEnd())
+    {
+        // unloaded files have no editor, and are never modified:
+        if(u == unloadedFiles.constEnd() || (e != editors.constEnd() && e.key() < u.key()))
+        {
+            syncRow(row++, e.key(), e.value());
+            ++e;
+        }
+        else
+        {
+            syncRow(row++, u.key(), nullptr);
+            ++u;
+        }
+    }
+
+    if(row < items_.size())
+    {
+        beginRemoveRows(QModelIndex(), row, items_.size() - 1);
+        items_.resize(row);
+        endRemoveRows();
+    }
+}
+
+void OpenFilesModel::syncRow(int row, const QString &path, Editor *editor)
+{
+    // rows before the path are of files which have been closed:
+    int n = 0;
+    while(row + n < items_.size() && items_[row + n].path < path) n++;
+    if(n)
+    {
+        beginRemoveRows(QModelIndex(), row, row + n - 1);
+        items_.remove(row, n);
+        endRemoveRows();
+    }
+
+    bool modified = editor && editor->needsSaving();
+    bool saving = editor && editor->isSaving();
+
+    if(row < items_.size() && items_[row].path == path)
+    {
+        Item &item = items_[row];
+        if(item.modified == modified && item.saving == saving) return;
+        item.modified = modified;
+        item.saving = saving;
+        emit dataChanged(index(row), index(row));
+    }
+    else
+    {
+        Item item;
+        item.path = path;
+        item.name = path.isEmpty() ? QStringLiteral("<embedded script>") : QDir::cleanPath(path);
+        item.modified = modified;
+        item.saving = saving;
+        beginInsertRows(QModelIndex(), row, row);
+        items_.insert(row, item);
+        endInsertRows();
+    }
+}
+
+int OpenFilesModel::row(const QString &path) const
+{
+    auto it = std::lower_bound(items_.begin(), items_.end(), path, [](const Item &item, const QString &p) {
+        return item.path < p;
+    });
+    if(it == items_.end() || it->path != path) return -1;
+    return int(it - items_.begin());
+}
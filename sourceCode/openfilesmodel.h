@@ -0,0 +1,42 @@
+#ifndef OPENFILESMODEL_H
+#define OPENFILESMODEL_H
+
+#include <QtWidgets>
+
+#include "common.h"
+
+class Editor;
+
+// the list of files open in a dialog (embedded script first, then files
+// sorted by path), used as the model of the open files combo box
+class OpenFilesModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    OpenFilesModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    // bring the rows in sync with the editors and unloaded files of a
+    // dialog; only rows which are added, removed, or whose modified/saving
+    // state changed are signaled
+    void sync(const QMap<QString, Editor*> &editors, const QMap<QString, EditorViewState> &unloadedFiles);
+    // row of the given path, or -1
+    int row(const QString &path) const;
+
+private:
+    void syncRow(int row, const QString &path, Editor *editor);
+
+    struct Item
+    {
+        QString path;
+        QString name;
+        bool modified {false};
+        bool saving {false};
+    };
+    QVector<Item> items_;
+};
+
+#endif // OPENFILESMODEL_H
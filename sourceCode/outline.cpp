@@ -0,0 +1,252 @@
+#include "outline.h"
+#include <SciLexer.h>
+#include <cstring>
+
+namespace {
+
+// parameter lists longer than this are truncated
+const int maxParamsLength = 200;
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\f';
+}
+
+inline bool isWord(const QByteArray &token, const char *word)
+{
+    return token.size() == int(std::strlen(word)) && std::memcmp(token.constData(), word, token.size()) == 0;
+}
+
+// the parameter list starting at the '(' at pair i, with the whitespace
+// collapsed; if multiline is false, it ends at the end of the line
+QByteArray parameters(const char *p, int n, int i, bool multiline)
+{
+    QByteArray params;
+    int depth = 0;
+    bool blank = false;
+    for(; i < n; i++)
+    {
+        char c = p[2 * i];
+        if(isNewline(c) || isBlank(c))
+        {
+            if(isNewline(c) && !multiline) break;
+            blank = true;
+            continue;
+        }
+        if(blank && !params.endsWith('(')) params += ' ';
+        blank = false;
+        params += c;
+        if(c == '(') depth++;
+        else if(c == ')' && --depth == 0) return params;
+        if(params.size() >= maxParamsLength) break;
+    }
+    return params + "...)";
+}
+
+} // namespace
+
+bool StyleOutline::supports(const QString &lang)
+{
+    return lang == "lua" || lang == "python";
+}
+
+void StyleOutline::reset(const QString &lang)
+{
+    lua_ = lang == "lua";
+    python_ = lang == "python";
+    scannedLines_ = 0;
+    state_ = State();
+    checkpoints_.clear();
+    entries_.clear();
+}
+
+void StyleOutline::invalidate(int line)
+{
+    if(line >= scannedLines_) return;
+    int chunk = line / chunkLines;
+    state_ = checkpoints_[chunk];
+    checkpoints_.resize(chunk);
+    entries_.resize(state_.entryCount);
+    scannedLines_ = chunk * chunkLines;
+}
+
+void StyleOutline::scan(const QByteArray &styled, int lineCount)
+{
+    if(scannedLines_ % chunkLines == 0 && checkpoints_.size() == scannedLines_ / chunkLines)
+    {
+        state_.entryCount = entries_.size();
+        checkpoints_.append(state_);
+    }
+    if(lua_) scanLua(styled);
+    if(python_) scanPython(styled);
+    scannedLines_ += lineCount;
+}
+
+void StyleOutline::scanLua(const QByteArray &styled)
+{
+    const char *p = styled.constData();
+    const int n = styled.size() / 2;
+    int line = scannedLines_;
+
+    QByteArray name;            // dotted name being read
+    bool nameOpen = false;      // name ends with '.' or ':'
+    bool function = false;      // after the 'function' keyword
+    QByteArray functionName;
+    int functionLine = 0;
+    int functionDepth = 0;
+
+    for(int i = 0; i < n; )
+    {
+        char c = p[2 * i];
+        int style = (unsigned char)p[2 * i + 1];
+        if(isNewline(c))
+        {
+            i++;
+            if(i < n && isNewline(p[2 * i]) && p[2 * i] != c) i++;
+            line++;
+            continue;
+        }
+        if(isBlank(c) || style == SCE_LUA_COMMENT || style == SCE_LUA_COMMENTLINE || style == SCE_LUA_COMMENTDOC)
+        {
+            i++;
+            continue;
+        }
+
+        // the name before '=' is only good for the token right after it:
+        QByteArray assigned = state_.assigned;
+        state_.assigned.clear();
+
+        int start = i;
+        if(style == SCE_LUA_OPERATOR)
+            i++;
+        else
+            while(i < n && (unsigned char)p[2 * i + 1] == style && !isNewline(p[2 * i]) && !isBlank(p[2 * i])) i++;
+        QByteArray token;
+        for(int k = start; k < i; k++) token += p[2 * k];
+
+        bool isName = style == SCE_LUA_IDENTIFIER || (style >= SCE_LUA_WORD2 && style <= SCE_LUA_WORD8);
+        if(function)
+        {
+            if(isName && (functionName.isEmpty() || nameOpen))
+            {
+                functionName += token;
+                nameOpen = false;
+                continue;
+            }
+            if(style == SCE_LUA_OPERATOR && (c == '.' || c == ':') && !functionName.isEmpty() && !nameOpen)
+            {
+                functionName += c;
+                nameOpen = true;
+                continue;
+            }
+            function = false;
+            nameOpen = false;
+            if(style == SCE_LUA_OPERATOR && c == '(' && !functionName.isEmpty())
+            {
+                OutlineEntry e;
+                e.name = QString::fromUtf8(functionName + parameters(p, n, start, false));
+                e.line = functionLine;
+                e.depth = functionDepth;
+                entries_.append(e);
+            }
+        }
+
+        if(isName)
+        {
+            if(!nameOpen) name.clear();
+            name += token;
+            nameOpen = false;
+        }
+        else if(style == SCE_LUA_OPERATOR && (c == '.' || c == ':') && !name.isEmpty() && !nameOpen)
+        {
+            name += c;
+            nameOpen = true;
+        }
+        else if(style == SCE_LUA_OPERATOR && c == '=' && !name.isEmpty() && !nameOpen
+                && !(i < n && p[2 * i] == '='))
+        {
+            state_.assigned = name;
+            name.clear();
+        }
+        else
+        {
+            name.clear();
+            nameOpen = false;
+            if(style == SCE_LUA_OPERATOR && c == '=' && i < n && p[2 * i] == '=')
+                i++; // '=='
+            if(style != SCE_LUA_WORD) continue;
+
+            if(isWord(token, "function"))
+            {
+                function = true;
+                functionName = assigned;
+                functionLine = line;
+                functionDepth = 0;
+                for(bool f : state_.blocks)
+                    if(f) functionDepth++;
+                state_.blocks.append(true);
+            }
+            else if(isWord(token, "do") || isWord(token, "if") || isWord(token, "repeat"))
+                state_.blocks.append(false);
+            else if((isWord(token, "end") || isWord(token, "until")) && !state_.blocks.isEmpty())
+                state_.blocks.removeLast();
+        }
+    }
+}
+
+void StyleOutline::scanPython(const QByteArray &styled)
+{
+    const char *p = styled.constData();
+    const int n = styled.size() / 2;
+    int line = scannedLines_;
+    int indent = 0;
+    bool lineStart = true;
+
+    for(int i = 0; i < n; )
+    {
+        char c = p[2 * i];
+        int style = (unsigned char)p[2 * i + 1];
+        if(isNewline(c))
+        {
+            i++;
+            if(i < n && isNewline(p[2 * i]) && p[2 * i] != c) i++;
+            line++;
+            indent = 0;
+            lineStart = true;
+            continue;
+        }
+        if(lineStart && isBlank(c))
+        {
+            indent = c == '\t' ? (indent / 8 + 1) * 8 : indent + 1;
+            i++;
+            continue;
+        }
+        lineStart = false;
+        if(style != SCE_P_DEFNAME && style != SCE_P_CLASSNAME)
+        {
+            i++;
+            continue;
+        }
+
+        int start = i;
+        while(i < n && (unsigned char)p[2 * i + 1] == style) i++;
+        QByteArray name;
+        for(int k = start; k < i; k++) name += p[2 * k];
+
+        while(!state_.indents.isEmpty() && state_.indents.last() >= indent)
+            state_.indents.removeLast();
+        OutlineEntry e;
+        e.line = line;
+        e.depth = state_.indents.size();
+        if(style == SCE_P_CLASSNAME)
+            e.name = QString::fromUtf8("class " + name);
+        else
+        {
+            int k = i;
+            while(k < n && isBlank(p[2 * k])) k++;
+            e.name = QString::fromUtf8(k < n && p[2 * k] == '(' ? name + parameters(p, n, k, true) : name);
+        }
+        entries_.append(e);
+        state_.indents.append(indent);
+    }
+}
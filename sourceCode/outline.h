@@ -0,0 +1,60 @@
+#ifndef OUTLINE_H
+#define OUTLINE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include "syntaxcheck.h"
+
+// outline (function navigator) of a Lua or Python document, built from the
+// styles assigned by the lexer, so that keywords in comments and strings
+// are not mistaken for definitions. the document is scanned in chunks of
+// lines, in idle time; the state of the scanner is saved at the start of
+// each chunk, so that after an edit only the chunks from the one
+// containing the changed line onwards are scanned again.
+class StyleOutline
+{
+public:
+    static const int chunkLines = 512;
+
+    static bool supports(const QString &lang);
+
+    void reset(const QString &lang);
+
+    // forget what was scanned from the chunk containing line onwards
+    void invalidate(int line);
+
+    // number of lines scanned so far
+    inline int scannedLines() const { return scannedLines_; }
+
+    // scan the next lineCount lines; styled are the (character, style)
+    // pairs of those lines, as returned by SCI_GETSTYLEDTEXT
+    void scan(const QByteArray &styled, int lineCount);
+
+    inline const QVector<OutlineEntry> & entries() const { return entries_; }
+
+private:
+    void scanLua(const QByteArray &styled);
+    void scanPython(const QByteArray &styled);
+
+    struct State
+    {
+        int entryCount {0};
+        // Lua: open blocks (true for functions), and the name followed by
+        // '=' if a function may be assigned to it:
+        QVector<bool> blocks;
+        QByteArray assigned;
+        // Python: indentation of the enclosing definitions
+        QVector<int> indents;
+    };
+
+    bool lua_ {false};
+    bool python_ {false};
+    int scannedLines_ {0};
+    State state_;
+    QVector<State> checkpoints_;
+    QVector<OutlineEntry> entries_;
+};
+
+#endif // OUTLINE_H
@@ -0,0 +1,141 @@
+#include "palette.h"
+#include "dialog.h"
+#include "editor.h"
+#include "toolbar.h"
+#include "stats.h"
+
+Palette::Palette(Dialog *parent)
+    : QFrame(parent, Qt::Popup),
+      parent(parent)
+{
+    setFrameStyle(QFrame::Panel | QFrame::Raised);
+    QVBoxLayout *layout = new QVBoxLayout;
+    layout->setContentsMargins(4, 4, 4, 4);
+    layout->setSpacing(4);
+    setLayout(layout);
+    layout->addWidget(edit = new QLineEdit);
+    edit->setPlaceholderText("Go to function, insert snippet or keyword, open file...");
+    edit->installEventFilter(this);
+    layout->addWidget(list = new QListWidget);
+    list->setUniformItemSizes(true);
+    list->setFocusPolicy(Qt::NoFocus);
+
+    connect(edit, &QLineEdit::textChanged, this, &Palette::filter);
+    connect(edit, &QLineEdit::returnPressed, this, &Palette::activate);
+    connect(list, &QListWidget::itemClicked, this, &Palette::activate);
+}
+
+Palette::~Palette()
+{
+}
+
+void Palette::popup()
+{
+    collect();
+
+    QRect r = parent->rect();
+    int w = qMin(600, r.width() - 20);
+    resize(w, qMin(400, r.height() - 20));
+    move(parent->mapToGlobal(QPoint((r.width() - w) / 2, parent->toolBar()->isVisible() ? parent->toolBar()->height() : 0)));
+
+    edit->clear();
+    filter();
+    show();
+    edit->setFocus();
+}
+
+void Palette::collect()
+{
+    STATS_SCOPE("Palette::collect");
+
+    index.clear();
+    items.clear();
+    auto add = [this](const QString &text, Kind kind, int line, const QString &data) {
+        index.add(text);
+        items.append({kind, line, data});
+    };
+
+    auto e = parent->activeEditor();
+    if(e->hasOutline())
+    {
+        const auto &outline = e->outline();
+        index.reserve(outline.size(), 32 * outline.size());
+        items.reserve(outline.size());
+        for(const auto &entry : outline)
+            add(entry.name, SymbolItem, entry.line, {});
+    }
+
+    for(const auto &s : parent->toolBar()->snippets().snippets())
+        add(s.first.isEmpty() ? s.second.name : s.first + "/" + s.second.name, SnippetItem, 0, s.second.content);
+
+    QStringList files = parent->editors().keys() + parent->unloadedFiles().keys();
+    files.sort();
+    for(const auto &path : files)
+        if(!path.isEmpty())
+            add(path, FileItem, 0, path);
+
+    for(const auto &kw : e->editorOptions().userKeywords)
+        add(kw.keyword, KeywordItem, 0, kw.keyword);
+}
+
+void Palette::filter()
+{
+    STATS_SCOPE("Palette::filter");
+
+    static const char *kindNames[] = {"function", "snippet", "file", "keyword"};
+
+    list->clear();
+    for(int i : index.match(edit->text(), maxResults))
+    {
+        QListWidgetItem *item = new QListWidgetItem(QStringLiteral("%1    (%2)").arg(index.text(i), kindNames[items[i].kind]));
+        item->setData(Qt::UserRole, i);
+        list->addItem(item);
+    }
+    list->setCurrentRow(0);
+}
+
+void Palette::activate()
+{
+    QListWidgetItem *current = list->currentItem();
+    hide();
+    if(!current) return;
+    const Item &item = items[current->data(Qt::UserRole).toInt()];
+
+    auto e = parent->activeEditor();
+    switch(item.kind)
+    {
+    case SymbolItem:
+        e->ensureLineVisible(item.line);
+        e->setCursorPosition(item.line, 0);
+        break;
+    case SnippetItem:
+        e->insert(item.data);
+        break;
+    case FileItem:
+        e = parent->openExternalFile(item.data);
+        break;
+    case KeywordItem:
+        e->replaceSelectedText(item.data);
+        break;
+    }
+    if(e) e->setFocus();
+}
+
+bool Palette::eventFilter(QObject *obj, QEvent *event)
+{
+    if(obj == edit && event->type() == QEvent::KeyPress)
+    {
+        // move through the results while typing in the line edit:
+        QKeyEvent *keyEvent = static_cast<QKeyEvent*>(event);
+        switch(keyEvent->key())
+        {
+        case Qt::Key_Up:
+        case Qt::Key_Down:
+        case Qt::Key_PageUp:
+        case Qt::Key_PageDown:
+            QApplication::sendEvent(list, event);
+            return true;
+        }
+    }
+    return QFrame::eventFilter(obj, event);
+}
@@ -0,0 +1,59 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <QtWidgets>
+
+#include "fuzzymatch.h"
+
+class Dialog;
+
+// Ctrl+P popup for jumping to a function of the outline, inserting a
+// snippet or a keyword of the API, or switching to an open file, by fuzzy
+// matching their names
+class Palette : public QFrame
+{
+    Q_OBJECT
+
+public:
+    Palette(Dialog *parent);
+    virtual ~Palette();
+
+public slots:
+    void popup();
+
+protected:
+    bool eventFilter(QObject *obj, QEvent *event) override;
+
+private slots:
+    void filter();
+    void activate();
+
+private:
+    void collect();
+
+    enum Kind
+    {
+        SymbolItem,
+        SnippetItem,
+        FileItem,
+        KeywordItem
+    };
+
+    struct Item
+    {
+        Kind kind;
+        int line;       // SymbolItem
+        QString data;   // content for Snippet, path for FileItem
+    };
+
+    // items shown at most
+    static const int maxResults = 100;
+
+    Dialog *parent;
+    QLineEdit *edit;
+    QListWidget *list;
+    FuzzyIndex index;
+    QVector<Item> items;
+};
+
+#endif // PALETTE_H
@@ -4,6 +4,8 @@
 #include "UI.h"
 #include <simPlusPlus/Plugin.h>
 #include "common.h"
+#include "stats.h"
+#include "trace.h"
 #include "stubs.h"
 #include <QtCore>
 #include <QHostInfo>
@@ -29,6 +31,17 @@ public:
         if(p)
             verboseErrors = *p;
 
+        traceSetThreadName("SIM");
+        auto t = sim::getBoolProperty(sim_handle_app, "customData.codeEditor.trace", {});
+        if(t && *t)
+        {
+            QString tracePath = QDir::temp().filePath(QStringLiteral("simCodeEditor-%1.trace.json").arg(QCoreApplication::applicationPid()));
+            if(traceStart(tracePath))
+                sim::addLog(sim_verbosity_infos, "writing trace to %s", tracePath.toStdString());
+            else
+                sim::addLog(sim_verbosity_errors, "cannot write trace to %s", tracePath.toStdString());
+        }
+
         simThread();
         sim = new SIM();
 
@@ -48,6 +61,7 @@ public:
 
     void onCleanup()
     {
+        traceStop();
         delete sim; //sim->deleteLater(); crashes on quit
         SIM_THREAD = NULL;
     }
@@ -55,6 +69,7 @@ public:
     void onUIInit()
     {
         uiThread();
+        traceSetThreadName("UI");
         ui = new UI(sim);
     }
 
@@ -76,6 +91,8 @@ public:
 
     char * codeEditor_openModal(const char *initText, const char *properties, int *positionAndSize)
     { // special: blocking until dlg closed
+        STATS_SCOPE("codeEditor_openModal");
+
         ASSERT_THREAD(!UI);
 
         sim::addLog(sim_verbosity_debug, "codeEditor_openModal: initText=%s, properties=%s", initText, properties);
@@ -86,6 +103,7 @@ public:
         }
         else
         {
+            STATS_SCOPE("SIM->UI openModal");
             if(sim)
                 sim->openModal(QString(initText), QString(properties), text, positionAndSize);
         }
@@ -98,6 +116,8 @@ public:
 
     int codeEditor_open(const char *initText, const char *properties)
     {
+        STATS_SCOPE("codeEditor_open");
+
         sim::addLog(sim_verbosity_debug, "codeEditor_open: initText=%s, properties=%s", initText, properties);
 
         int handle = -1;
@@ -105,6 +125,7 @@ public:
             ui->open(QString(initText), QString(properties), &handle);
         else
         {
+            STATS_SCOPE("SIM->UI open");
             if(sim)
                 sim->open(QString(initText), QString(properties), &handle);
         }
@@ -116,12 +137,15 @@ public:
 
     int codeEditor_setText(int handle, const char *text, int insertMode)
     {
+        STATS_SCOPE("codeEditor_setText");
+
         sim::addLog(sim_verbosity_debug, "codeEditor_setText: handle=%d, text=%s, insertMode=%d", handle, text, insertMode);
 
         if(QThread::currentThreadId() == UI_THREAD)
             ui->setText(handle, QString(text), insertMode);
         else
         {
+            STATS_SCOPE("SIM->UI setText");
             if(sim)
                 sim->setText(handle, QString(text), insertMode);
         }
@@ -133,6 +157,8 @@ public:
 
     char * codeEditor_getText(int handle, int* posAndSize)
     {
+        STATS_SCOPE("codeEditor_getText");
+
         sim::addLog(sim_verbosity_debug, "codeEditor_getText: handle=%d", handle);
 
         QString text;
@@ -140,6 +166,7 @@ public:
             ui->getText(handle, &text, posAndSize);
         else
         {
+            STATS_SCOPE("SIM->UI getText");
             if(sim)
                 sim->getText(handle, &text, posAndSize);
         }
@@ -151,12 +178,15 @@ public:
 
     int codeEditor_show(int handle, int showState)
     {
+        STATS_SCOPE("codeEditor_show");
+
         sim::addLog(sim_verbosity_debug, "codeEditor_getText: handle=%d, showState=%d", handle, showState);
 
         if(QThread::currentThreadId() == UI_THREAD)
             ui->show(handle, showState);
         else
         {
+            STATS_SCOPE("SIM->UI show");
             if(sim)
                 sim->show(handle, showState);
         }
@@ -168,12 +198,15 @@ public:
 
     int codeEditor_close(int handle, int *positionAndSize)
     {
+        STATS_SCOPE("codeEditor_close");
+
         sim::addLog(sim_verbosity_debug, "codeEditor_close: handle=%d", handle);
 
         if(QThread::currentThreadId() == UI_THREAD)
             ui->close(handle, positionAndSize);
         else
         {
+            STATS_SCOPE("SIM->UI close");
             if(sim)
                 sim->close(handle, positionAndSize);
         }
@@ -183,6 +216,38 @@ public:
         return -1;
     }
 
+    char * codeEditor_getStats(int reset)
+    {
+        return stringBufferCopy(statsToJson(reset != 0));
+    }
+
+    void getStats(getStats_in *in, getStats_out *out)
+    {
+        out->stats = statsToJson(in->reset).toStdString();
+    }
+
+    QString memoryUsage(int handle)
+    {
+        QString json;
+        if(QThread::currentThreadId() == UI_THREAD)
+            ui->getMemoryUsage(handle, &json);
+        else if(sim)
+            sim->getMemoryUsage(handle, &json);
+        return json;
+    }
+
+    char * codeEditor_getMemoryUsage(int handle)
+    {
+        STATS_SCOPE("codeEditor_getMemoryUsage");
+
+        return stringBufferCopy(memoryUsage(handle));
+    }
+
+    void getMemoryUsage(getMemoryUsage_in *in, getMemoryUsage_out *out)
+    {
+        out->usage = memoryUsage(in->handle).toStdString();
+    }
+
     QUrl apiReferenceForSymbol(const QString &sym)
     {
         // split symbol (e.g.: "sim.getObject" -> "sim", "getObject")
@@ -361,3 +426,13 @@ SIM_DLLEXPORT int codeEditor_close(int handle, int *positionAndSize)
 {
     return sim::plugin->codeEditor_close(handle, positionAndSize);
 }
+
+SIM_DLLEXPORT char * codeEditor_getStats(int reset)
+{
+    return sim::plugin->codeEditor_getStats(reset);
+}
+
+SIM_DLLEXPORT char * codeEditor_getMemoryUsage(int handle)
+{
+    return sim::plugin->codeEditor_getMemoryUsage(handle);
+}
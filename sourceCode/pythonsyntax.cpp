@@ -0,0 +1,500 @@
+#include "pythonsyntax.h"
+#include <cstring>
+
+namespace {
+
+inline bool isNameStart(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (c & 0x80);
+}
+
+inline bool isNameChar(char c)
+{
+    return isNameStart(c) || (c >= '0' && c <= '9');
+}
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\f';
+}
+
+bool isStringPrefix(const char *s, int len)
+{
+    if(len > 2) return false;
+    char a = s[0] | 0x20, b = len == 2 ? (s[1] | 0x20) : 0;
+    if(len == 1) return a == 'r' || a == 'u' || a == 'b' || a == 'f';
+    return (a == 'r' && (b == 'b' || b == 'f')) || ((a == 'b' || a == 'f') && b == 'r');
+}
+
+const char *compoundKeywords[] = {
+    "if", "elif", "else", "while", "for", "try", "except", "finally", "with", "def", "class", "async"
+};
+
+struct SyntaxError
+{
+    int start;
+    int end;
+    int line;
+    QString message;
+};
+
+class BlockChecker
+{
+public:
+    BlockChecker(const char *data, int begin, int end, QVector<Diagnostic> &diagnostics)
+        : s(data), begin(begin), n(end), p(begin), diagnostics(diagnostics)
+    {
+        indents.append({0, 0});
+    }
+
+    void run()
+    {
+        try
+        {
+            while(p < n)
+                physicalLine();
+            if(continuation)
+                error(n, n, line, QStringLiteral("unexpected EOF while parsing"));
+            if(!brackets.isEmpty())
+                error(brackets.last().pos, brackets.last().pos + 1, brackets.last().line, "'" + QString(QChar(brackets.last().ch)) + "' was never closed");
+            if(inLogical)
+                finishLogical();
+            if(expectBlock)
+                missingBlock();
+        }
+        catch(SyntaxError &e)
+        {
+            add(Diagnostic::Error, e.start, e.end, e.line, e.message);
+        }
+    }
+
+private:
+    struct Token
+    {
+        enum Kind { Name, Number, String, Op } kind;
+        char ch;
+        int start;
+        int end;
+        int line;
+    };
+
+    struct Bracket
+    {
+        char ch;
+        int pos;
+        int line;
+    };
+
+    void add(Diagnostic::Severity severity, int start, int end, int line, const QString &message)
+    {
+        Diagnostic d;
+        d.severity = severity;
+        d.start = start - begin;
+        d.length = end - start;
+        d.line = line;
+        d.message = message;
+        diagnostics.append(d);
+    }
+
+    [[noreturn]] void error(int start, int end, int line, const QString &message)
+    {
+        throw SyntaxError {start, end, line, message};
+    }
+
+    // reported at the ':' of the header, like CPython reports it at the header line
+    [[noreturn]] void missingBlock()
+    {
+        error(blockOpener.start, blockOpener.end, blockOpener.line, "expected an indented block after " + blockWhat);
+    }
+
+    bool isWord(const Token &t, const char *w) const
+    {
+        return t.kind == Token::Name && int(std::strlen(w)) == t.end - t.start && std::memcmp(w, s + t.start, t.end - t.start) == 0;
+    }
+
+    void physicalLine()
+    {
+        int lineStart = p;
+        if(!inLogical)
+        {
+            // measure the indentation with tabs of 8 and of 1 column(s), as
+            // the tokenizer of CPython does to detect inconsistent tabs:
+            int col = 0, altcol = 0;
+            bool tabs = false, spaces = false;
+            for(; p < n && isBlank(s[p]); p++)
+            {
+                if(s[p] == ' ') col++, altcol++, spaces = true;
+                else if(s[p] == '\t') col = (col / 8 + 1) * 8, altcol++, tabs = true;
+                else col = altcol = 0;
+            }
+            if(p >= n || s[p] == '#' || isNewline(s[p]))
+            {
+                // blank lines and comments don't count
+                while(p < n && !isNewline(s[p])) p++;
+                endOfLine();
+                return;
+            }
+            if(tabs && spaces)
+                add(Diagnostic::Warning, lineStart, p, line, QStringLiteral("indentation mixes tabs and spaces"));
+            indent(lineStart, col, altcol);
+            inLogical = true;
+            tokens.clear();
+            colon = false;
+            lastIsColon = false;
+        }
+
+        while(p < n && !isNewline(s[p]))
+        {
+            char c = s[p];
+            if(isBlank(c))
+                p++;
+            else if(c == '#')
+            {
+                while(p < n && !isNewline(s[p])) p++;
+            }
+            else if(c == '\\')
+            {
+                if(p + 1 < n && !isNewline(s[p + 1]))
+                    error(p, p + 1, line, QStringLiteral("unexpected character after line continuation character"));
+                p++;
+                continuation = true;
+                break;
+            }
+            else if(c == '"' || c == '\'')
+                string(p);
+            else if(isNameStart(c))
+            {
+                int start = p;
+                while(p < n && isNameChar(s[p])) p++;
+                if(p < n && (s[p] == '"' || s[p] == '\'') && isStringPrefix(s + start, p - start))
+                    string(start);
+                else
+                    token(Token::Name, 0, start);
+            }
+            else if(c >= '0' && c <= '9')
+            {
+                int start = p;
+                while(p < n && (isNameChar(s[p]) || s[p] == '.' || ((s[p] == '+' || s[p] == '-') && (s[p - 1] | 0x20) == 'e')))
+                    p++;
+                token(Token::Number, 0, start);
+            }
+            else
+            {
+                int start = p++;
+                if(c == '(' || c == '[' || c == '{')
+                    brackets.append({c, start, line});
+                else if(c == ')' || c == ']' || c == '}')
+                {
+                    if(brackets.isEmpty())
+                        error(start, p, line, "unmatched '" + QString(QChar(c)) + "'");
+                    char open = brackets.last().ch;
+                    if((open == '(' && c != ')') || (open == '[' && c != ']') || (open == '{' && c != '}'))
+                        error(start, p, line, "closing parenthesis '" + QString(QChar(c)) + "' does not match opening parenthesis '" + QString(QChar(open)) + "'");
+                    brackets.removeLast();
+                }
+                token(Token::Op, c, start);
+            }
+        }
+        endOfLine();
+    }
+
+    void endOfLine()
+    {
+        if(p < n)
+        {
+            p = skipNewline(s, n, p);
+            line++;
+        }
+        if(continuation && p < n)
+        {
+            continuation = false;
+            return;
+        }
+        if(!brackets.isEmpty() || !inLogical || continuation) return;
+        finishLogical();
+    }
+
+    void string(int start)
+    {
+        char quote = s[p];
+        int startLine = line;
+        if(p + 2 < n && s[p + 1] == quote && s[p + 2] == quote)
+        {
+            for(p += 3;; )
+            {
+                if(p >= n)
+                {
+                    int eol = start;
+                    while(eol < n && !isNewline(s[eol])) eol++;
+                    error(start, eol, startLine, QStringLiteral("unterminated triple-quoted string literal"));
+                }
+                if(s[p] == '\\' && p + 1 < n && !isNewline(s[p + 1]))
+                    p += 2;
+                else if(s[p] == '\\')
+                    p++;
+                else if(isNewline(s[p]))
+                {
+                    p = skipNewline(s, n, p);
+                    line++;
+                }
+                else if(s[p] == quote && p + 2 < n && s[p + 1] == quote && s[p + 2] == quote)
+                {
+                    p += 3;
+                    break;
+                }
+                else p++;
+            }
+        }
+        else
+        {
+            for(p++;; )
+            {
+                if(p >= n || isNewline(s[p]))
+                    error(start, p, startLine, QStringLiteral("unterminated string literal"));
+                if(s[p] == '\\' && p + 1 < n && isNewline(s[p + 1]))
+                {
+                    p = skipNewline(s, n, p + 1);
+                    line++;
+                }
+                else if(s[p] == '\\')
+                    p += 2;
+                else if(s[p] == quote)
+                {
+                    p++;
+                    break;
+                }
+                else p++;
+            }
+        }
+        token(Token::String, 0, start);
+    }
+
+    void token(Token::Kind kind, char ch, int start)
+    {
+        Token t {kind, ch, start, p, line};
+        // only the head of the logical line matters, and whether it ends with ':'
+        if(tokens.size() < 4) tokens.append(t);
+        lastIsColon = kind == Token::Op && ch == ':' && brackets.isEmpty();
+        if(lastIsColon && !colon)
+        {
+            colon = true;
+            colonToken = t;
+        }
+        last = t;
+    }
+
+    void indent(int lineStart, int col, int altcol)
+    {
+        auto inconsistent = [&] {
+            error(lineStart, p, line, QStringLiteral("inconsistent use of tabs and spaces in indentation"));
+        };
+        const Indentation &top = indents.last();
+        if(col == top.col)
+        {
+            if(altcol != top.altcol) inconsistent();
+            if(expectBlock)
+                missingBlock();
+        }
+        else if(col > top.col)
+        {
+            if(altcol <= top.altcol) inconsistent();
+            if(!expectBlock)
+                error(lineStart, p, line, QStringLiteral("unexpected indent"));
+            indents.append({col, altcol});
+        }
+        else
+        {
+            while(indents.size() > 1 && col < indents.last().col)
+                indents.removeLast();
+            if(col != indents.last().col)
+                error(lineStart, p, line, QStringLiteral("unindent does not match any outer indentation level"));
+            if(altcol != indents.last().altcol) inconsistent();
+            if(expectBlock)
+                missingBlock();
+        }
+        expectBlock = false;
+    }
+
+    void finishLogical()
+    {
+        inLogical = false;
+        if(tokens.isEmpty()) return;
+
+        int k = isWord(tokens[0], "async") && tokens.size() > 1 ? 1 : 0;
+        const Token &head = tokens[k];
+        bool compound = false;
+        for(const char *w : compoundKeywords)
+            compound = compound || isWord(head, w);
+        // (keywords used as names, e.g. "else = 1", are not headers:)
+        if(compound && tokens.size() > k + 1 && tokens[k + 1].kind == Token::Op && tokens[k + 1].ch == '=')
+            compound = false;
+        // "match" and "case" are soft keywords: the line is a header only if
+        // it starts with them and ends with a ':' outside of brackets (else
+        // e.g. "match = re.match(...)" or "case: int = 0")
+        if(k == 0 && (isWord(head, "match") || isWord(head, "case")))
+            compound = lastIsColon && tokens.size() > 1 && !(tokens[1].kind == Token::Op && tokens[1].ch == ':');
+        if(!compound) return;
+
+        if(isWord(head, "def") || isWord(head, "class"))
+        {
+            bool def = isWord(head, "def");
+            if(tokens.size() <= k + 1 || tokens[k + 1].kind != Token::Name)
+            {
+                const Token &t = tokens.size() > k + 1 ? tokens[k + 1] : head;
+                error(t.start, t.end, t.line, def ? QStringLiteral("invalid syntax (expected a function name)") : QStringLiteral("invalid syntax (expected a class name)"));
+            }
+            if(def && (tokens.size() <= k + 2 || tokens[k + 2].kind != Token::Op || tokens[k + 2].ch != '('))
+            {
+                const Token &t = tokens.size() > k + 2 ? tokens[k + 2] : tokens[k + 1];
+                error(t.start, t.end, t.line, QStringLiteral("invalid syntax (expected '(')"));
+            }
+        }
+        if(!colon)
+            error(last.start, last.end, last.line, QStringLiteral("expected ':'"));
+
+        if(lastIsColon)
+        {
+            expectBlock = true;
+            blockOpener = colonToken;
+            if(isWord(head, "def"))
+                blockWhat = QStringLiteral("function definition");
+            else if(isWord(head, "class"))
+                blockWhat = QStringLiteral("class definition");
+            else
+                blockWhat = "'" + QString::fromUtf8(s + head.start, head.end - head.start) + "' statement";
+        }
+    }
+
+    struct Indentation
+    {
+        int col;
+        int altcol;
+    };
+
+    const char *s;
+    int begin;
+    int n;
+    int p;
+    int line {0};
+    QVector<Diagnostic> &diagnostics;
+    QVector<Indentation> indents;
+    QVector<Bracket> brackets;
+    bool continuation {false};
+    bool inLogical {false};
+    QVector<Token> tokens;
+    Token last {};
+    bool colon {false};
+    Token colonToken {};
+    bool lastIsColon {false};
+    bool expectBlock {false};
+    Token blockOpener {};
+    QString blockWhat;
+};
+
+// offsets and lines of the blocks: the lines starting in the first column
+// outside of brackets, strings and line continuations
+void splitBlocks(const char *s, int n, QVector<int> &starts, QVector<int> &lines)
+{
+    starts.append(0);
+    lines.append(0);
+    int line = 0, depth = 0;
+    bool continuation = false;
+    int i = 0;
+    while(i < n)
+    {
+        char c = s[i];
+        if(isNewline(c))
+        {
+            i = skipNewline(s, n, i);
+            line++;
+            if(!continuation && depth == 0 && i < n && !isBlank(s[i]) && !isNewline(s[i]) && s[i] != '#')
+            {
+                starts.append(i);
+                lines.append(line);
+            }
+            continuation = false;
+        }
+        else if(c == '#')
+        {
+            while(i < n && !isNewline(s[i])) i++;
+        }
+        else if(c == '\\')
+        {
+            i++;
+            if(i < n && isNewline(s[i]))
+            {
+                i = skipNewline(s, n, i);
+                line++;
+            }
+        }
+        else if(c == '"' || c == '\'')
+        {
+            if(i + 2 < n && s[i + 1] == c && s[i + 2] == c)
+            {
+                for(i += 3; i < n; )
+                {
+                    if(s[i] == '\\' && i + 1 < n && !isNewline(s[i + 1]))
+                        i += 2;
+                    else if(isNewline(s[i]))
+                    {
+                        i = skipNewline(s, n, i);
+                        line++;
+                    }
+                    else if(s[i] == c && i + 2 < n && s[i + 1] == c && s[i + 2] == c)
+                    {
+                        i += 3;
+                        break;
+                    }
+                    else i++;
+                }
+            }
+            else
+            {
+                for(i++; i < n && s[i] != c && !isNewline(s[i]); i++)
+                    if(s[i] == '\\' && i + 1 < n && !isNewline(s[i + 1]))
+                        i++;
+                if(i < n && s[i] == c) i++;
+            }
+        }
+        else
+        {
+            if(c == '(' || c == '[' || c == '{') depth++;
+            else if((c == ')' || c == ']' || c == '}') && depth > 0) depth--;
+            i++;
+        }
+    }
+}
+
+} // namespace
+
+QVector<Diagnostic> PythonSyntaxChecker::check(const QByteArray &text)
+{
+    const char *s = text.constData();
+    int n = text.size();
+
+    QVector<int> starts, lines;
+    splitBlocks(s, n, starts, lines);
+
+    QVector<Diagnostic> diagnostics;
+    QHash<size_t, QVector<Diagnostic>> cache;
+    for(int i = 0; i < starts.size(); i++)
+    {
+        int end = i + 1 < starts.size() ? starts[i + 1] : n;
+        size_t hash = chunkHash(s + starts[i], end - starts[i]);
+        QVector<Diagnostic> block;
+        auto it = cache_.constFind(hash);
+        if(it != cache_.constEnd())
+            block = *it;
+        else
+            BlockChecker(s, starts[i], end, block).run();
+        cache.insert(hash, block);
+        for(Diagnostic d : block)
+        {
+            d.start += starts[i];
+            d.line += lines[i];
+            diagnostics.append(d);
+        }
+    }
+    cache_ = cache;
+    return diagnostics;
+}
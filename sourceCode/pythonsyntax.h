@@ -0,0 +1,23 @@
+#ifndef PYTHONSYNTAX_H
+#define PYTHONSYNTAX_H
+
+#include "syntaxcheck.h"
+
+// Python tokenizer-level checker: indentation (unexpected indent, dedent
+// to no outer level, inconsistent or mixed tabs and spaces, missing
+// indented block), brackets, unterminated strings, and the structure of
+// compound statement headers (def/class name and parameters, ':'). the
+// document is split in blocks at the lines starting in the first column
+// (where the indentation stack is empty), and only blocks whose text
+// changed are checked again.
+class PythonSyntaxChecker : public SyntaxChecker
+{
+protected:
+    QVector<Diagnostic> check(const QByteArray &text) override;
+
+private:
+    // diagnostics of each block, relative to the start of the block:
+    QHash<size_t, QVector<Diagnostic>> cache_;
+};
+
+#endif // PYTHONSYNTAX_H
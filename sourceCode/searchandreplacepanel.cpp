@@ -2,6 +2,7 @@
 #include "dialog.h"
 #include "editor.h"
 #include "statusbar.h"
+#include "documentregistry.h"
 
 SearchAndReplacePanel::SearchAndReplacePanel(Dialog *parent)
     : QWidget(parent),
@@ -12,6 +13,8 @@ SearchAndReplacePanel::SearchAndReplacePanel(Dialog *parent)
     layout->setColumnStretch(1, 10);
     layout->addWidget(chkRegExp = new QCheckBox("Regular expression"), 1, 5);
     layout->addWidget(chkCaseSens = new QCheckBox("Case sensitive"), 2, 5);
+    layout->addWidget(chkAllFiles = new QCheckBox("Find all in all files"), 3, 5);
+    chkAllFiles->setToolTip("Find all searches all open files and the files in the script search paths");
     layout->addWidget(lblFind = new QLabel("Find:"), 1, 0);
     lblFind->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
     layout->addWidget(editFind = new QComboBox, 1, 1, 1, 2);
@@ -22,13 +25,17 @@ SearchAndReplacePanel::SearchAndReplacePanel(Dialog *parent)
         find();
     });
     layout->addWidget(btnFind = new QToolButton, 1, 3);
+    layout->addWidget(btnFindAll = new QToolButton, 1, 4);
     QAction *actFind = new QAction("Find");
+    QAction *actFindAll = new QAction("Find all");
     QAction *actReplace = new QAction("Replace");
     QAction *actReplaceAndFind = new QAction("Replace and find");
     actReplaceAndFind->setCheckable(true);
     actReplaceAndFind->setChecked(true);
     btnFind->setDefaultAction(actFind);
     btnFind->setToolTip("");
+    btnFindAll->setDefaultAction(actFindAll);
+    btnFindAll->setToolTip("");
     layout->addWidget(btnClose = new QPushButton, 1, 6);
     layout->addWidget(lblReplace = new QLabel("Replace with:"), 2, 0);
     lblReplace->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
@@ -36,12 +43,22 @@ SearchAndReplacePanel::SearchAndReplacePanel(Dialog *parent)
     editReplace->setEditable(true);
     editReplace->setInsertPolicy(QComboBox::InsertAtTop);
     layout->addWidget(btnReplace = new QToolButton, 2, 3);
+    layout->addWidget(btnReplaceAll = new QToolButton, 2, 4);
+    QAction *actReplaceAll = new QAction("Replace all");
+    btnReplaceAll->setDefaultAction(actReplaceAll);
+    btnReplaceAll->setToolTip("");
     btnReplace->setPopupMode(QToolButton::MenuButtonPopup);
     btnReplace->setDefaultAction(actReplace);
     btnReplace->setToolTip("");
     QMenu *m = new QMenu(parent);
     m->addAction(actReplaceAndFind);
     btnReplace->setMenu(m);
+    layout->addWidget(lstResults = new QTreeWidget, 4, 0, 1, 7);
+    lstResults->setColumnCount(2);
+    lstResults->setHeaderLabels({"Line", "Text"});
+    lstResults->setRootIsDecorated(false);
+    lstResults->setUniformRowHeights(true);
+    lstResults->setVisible(false);
     setLayout(layout);
     btnClose->setIcon(style()->standardIcon(QStyle::SP_TitleBarCloseButton));
     btnClose->setFlat(true);
@@ -50,13 +67,53 @@ SearchAndReplacePanel::SearchAndReplacePanel(Dialog *parent)
     connect(actFind, &QAction::triggered, [=] (bool v) {
         find();
     });
+    connect(actFindAll, &QAction::triggered, [=] (bool v) {
+        findAll();
+    });
+    connect(lstResults, &QTreeWidget::itemClicked, [=] (QTreeWidgetItem *item) {
+        Editor *editor = findAllState.editor;
+        bool ok = false;
+        int start = item->data(0, Qt::UserRole).toInt(&ok);
+        int length = item->data(0, Qt::UserRole + 1).toInt();
+        if(!ok) return;
+        QVariant path = item->data(0, Qt::UserRole + 2);
+        if(path.isValid())
+        {
+            // the offsets of matches in open buffers are those of the
+            // revision that was searched (unloaded files are unmodified):
+            QVariant revision = item->data(0, Qt::UserRole + 3);
+            Editor *open = parent->editors().value(path.toString());
+            bool stale = open ? qint64(open->revision()) != revision.toLongLong() : !parent->unloadedFiles().contains(path.toString());
+            if(revision.isValid() && stale)
+            {
+                parent->statusBar()->showMessage("The file has changed since the search, find all again.", 4000);
+                return;
+            }
+            editor = path.toString().isEmpty() ? parent->editors().value("") : parent->openExternalFile(path.toString());
+        }
+        if(!editor) return;
+        parent->switchEditor(editor);
+        editor->SendScintilla(QsciScintillaBase::SCI_SETSEL, (unsigned long)start, (long)(start + length));
+        editor->setFocus();
+    });
+    // restart the search when the document changes:
+    findAllRestartTimer = new QTimer(this);
+    findAllRestartTimer->setSingleShot(true);
+    findAllRestartTimer->setInterval(300);
+    connect(findAllRestartTimer, &QTimer::timeout, [=] {
+        if(findAllState.editor)
+            startFindAll(findAllState.editor, findAllState.opts);
+    });
     connect(actReplace, &QAction::triggered, [=] (bool v) {
-        replace();
-        if(actReplaceAndFind->isChecked()) find();
+        // when the selection is not a match, the first click selects one:
+        if(!replace() || actReplaceAndFind->isChecked()) find();
+    });
+    connect(actReplaceAll, &QAction::triggered, [=] (bool v) {
+        replaceAll();
     });
     hide();
 
-    QList<QWidget*> w = {editFind, editReplace, btnFind, btnReplace};
+    QList<QWidget*> w = {editFind, editReplace, btnFind, btnFindAll, btnReplace, btnReplaceAll};
     for(int i = 0; i < w.size() - 1; i++)
         setTabOrder(w[i], w[i + 1]);
 }
@@ -109,6 +166,11 @@ void SearchAndReplacePanel::show()
 
 void SearchAndReplacePanel::hide()
 {
+    cancelFindAll();
+    clearSearchMatches();
+    findAllState.editor = nullptr;
+    lstResults->clear();
+    lstResults->setVisible(false);
     QWidget::hide();
     emit hidden();
 }
@@ -123,21 +185,279 @@ void SearchAndReplacePanel::find()
 {
     Editor *sci = parent->activeEditor();
     bool shift = QGuiApplication::keyboardModifiers() & Qt::ShiftModifier;
-    // FIXME: reverse search does not work. bug in QScintilla?
     QString what = editFind->currentText();
     if(editFind->findText(what) == -1) editFind->addItem(what);
-    if(!sci->findFirst(what, chkRegExp->isChecked(), chkCaseSens->isChecked(), false, false, !shift))
+    SearchOptions opts = searchOptions();
+    if(opts.regExp && !QRegularExpression(opts.what).isValid())
     {
-        if(sci->findFirst(what, chkRegExp->isChecked(), chkCaseSens->isChecked(), false, true, !shift))
-            parent->statusBar()->showMessage("Search reached end. Continuing from top.", 4000);
-        else
-            parent->statusBar()->showMessage("No occurrences found.", 4000);
+        parent->statusBar()->showMessage("Invalid regular expression.", 4000);
+        return;
     }
+    bool wrapped = false;
+    if(!sci->findMatch(opts, !shift, &wrapped))
+        parent->statusBar()->showMessage("No occurrences found.", 4000);
+    else if(wrapped)
+        parent->statusBar()->showMessage(shift ? "Search reached top. Continuing from bottom." : "Search reached end. Continuing from top.", 4000);
+}
+
+void SearchAndReplacePanel::findAll()
+{
+    QString what = editFind->currentText();
+    if(editFind->findText(what) == -1) editFind->addItem(what);
+    SearchOptions opts = searchOptions();
+    clearSearchMatches();
+    if(chkAllFiles->isChecked())
+        startFindAllInFiles(opts);
+    else
+        startFindAll(parent->activeEditor(), opts);
+}
+
+void SearchAndReplacePanel::clearSearchMatches()
+{
+    for(auto editor : parent->editors())
+        editor->setSearchMatches({});
+}
+
+void SearchAndReplacePanel::cancelFindAll()
+{
+    if(findAllState.cancel)
+        *findAllState.cancel = true;
+    findAllState.cancel.reset();
+    findAllState.generation++;
+    disconnect(findAllState.textChangedConnection);
+    findAllRestartTimer->stop();
+}
+
+void SearchAndReplacePanel::startFindAll(Editor *editor, const SearchOptions &opts)
+{
+    cancelFindAll();
+
+    findAllState.editor = editor;
+    findAllState.opts = opts;
+    findAllState.count = 0;
+    findAllState.shown = 0;
+    findAllState.cancel = std::make_shared<std::atomic<bool>>(false);
+    findAllState.textChangedConnection = connect(editor, &QsciScintilla::textChanged, findAllRestartTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    lstResults->clear();
+    lstResults->setRootIsDecorated(false);
+    lstResults->setVisible(true);
+    editor->setSearchMatches({});
+    parent->statusBar()->showMessage("Searching...");
+
+    // scan a snapshot of the document on a worker thread, and stream the
+    // results back to the UI thread (stale results are discarded):
+    // (matches of an older revision of the text are discarded as well)
+    DocumentSnapshot snapshot = editor->snapshot();
+    QPointer<Editor> target(editor);
+    auto cancel = findAllState.cancel;
+    quint64 generation = findAllState.generation;
+    QPointer<SearchAndReplacePanel> self(this);
+    auto deliver = [self, generation, target, snapshot] (std::function<void()> f) {
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [=] {
+            if(self && self->findAllState.generation == generation && isCurrentRevision(target, snapshot.revision)) f();
+        }, Qt::QueuedConnection);
+    };
+    analysisPool()->start([=] {
+        bool ok = ::findAll(snapshot.text, opts, *cancel, [=] (const QVector<SearchMatch> &matches) {
+            deliver([=] { self->addFindAllResults(matches); });
+        });
+        if(!*cancel)
+            deliver([=] { self->finishFindAll(ok); });
+    });
 }
 
-void SearchAndReplacePanel::replace()
+void SearchAndReplacePanel::startFindAllInFiles(const SearchOptions &opts)
 {
-    QString what = editReplace->currentText();
-    if(editReplace->findText(what) == -1) editReplace->addItem(what);
-    parent->activeEditor()->replace(what);
+    cancelFindAll();
+
+    if(opts.regExp && !QRegularExpression(opts.what).isValid())
+    {
+        parent->statusBar()->showMessage("Invalid regular expression.", 4000);
+        return;
+    }
+
+    findAllState.editor = nullptr;
+    findAllState.opts = opts;
+    findAllState.count = 0;
+    findAllState.shown = 0;
+    findAllState.cancel = std::make_shared<std::atomic<bool>>(false);
+    lstResults->clear();
+    lstResults->setRootIsDecorated(true);
+    lstResults->setVisible(true);
+    parent->statusBar()->showMessage("Searching...");
+
+    // open files are searched from snapshots of their buffers:
+    QVector<QPair<QString, DocumentSnapshot>> buffers;
+    QStringList openPaths;
+    const auto &editors = parent->editors();
+    for(auto it = editors.cbegin(); it != editors.cend(); ++it)
+    {
+        buffers << qMakePair(it.key(), it.value()->snapshot());
+        if(!it.key().isEmpty())
+            openPaths << it.key();
+    }
+    // unloaded files are unmodified, so they are searched on disk:
+    QStringList unloadedPaths = parent->unloadedFiles().keys();
+    QVector<QString> searchPath = parent->options().scriptSearchPath;
+    qint64 maxSize = parent->options().hugeFileThreshold;
+
+    auto cancel = findAllState.cancel;
+    quint64 generation = findAllState.generation;
+    QPointer<SearchAndReplacePanel> self(this);
+    auto deliver = [self, generation] (std::function<void()> f) {
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [=] {
+            if(self && self->findAllState.generation == generation) f();
+        }, Qt::QueuedConnection);
+    };
+    analysisPool()->start([=] {
+        // files are compared by the key the documents are registered with,
+        // as the same file can be given by different paths:
+        QSet<QString> searched;
+        for(const auto &path : openPaths)
+            searched << DocumentRegistry::key(path);
+        QStringList files;
+        for(const auto &file : unloadedPaths + scriptSearchPathFiles(searchPath))
+        {
+            QString key = DocumentRegistry::key(file);
+            if(searched.contains(key)) continue;
+            searched << key;
+            files << file;
+        }
+
+        // one task per file, run by the threads of the analysis pool:
+        auto remaining = std::make_shared<std::atomic<int>>(buffers.size() + files.size());
+        auto taskDone = [=] {
+            if(--*remaining == 0 && !*cancel)
+                deliver([=] { self->finishFindAll(true); });
+        };
+        for(const auto &buffer : buffers)
+        {
+            analysisPool()->start([=] {
+                QVector<SearchMatch> matches;
+                ::findAll(buffer.second.text, opts, *cancel, [&] (const QVector<SearchMatch> &chunk) { matches += chunk; });
+                // (matches in a buffer edited meanwhile are dropped)
+                if(!matches.isEmpty() && !*cancel)
+                    deliver([=] {
+                        Editor *editor = self->parent->editors().value(buffer.first);
+                        if(editor && editor->revision() == buffer.second.revision)
+                            self->addFindAllResults(buffer.first, matches, qint64(buffer.second.revision));
+                    });
+                taskDone();
+            });
+        }
+        for(const auto &file : files)
+        {
+            analysisPool()->start([=] {
+                QVector<SearchMatch> matches;
+                if(!*cancel && findAllInFile(file, opts, *cancel, matches, maxSize) && !matches.isEmpty())
+                    deliver([=] { self->addFindAllResults(file, matches); });
+                taskDone();
+            });
+        }
+        if(buffers.isEmpty() && files.isEmpty())
+            deliver([=] { self->finishFindAll(true); });
+    });
+}
+
+void SearchAndReplacePanel::addFindAllResults(const QString &path, const QVector<SearchMatch> &matches, qint64 revision)
+{
+    const int maxItems = 10000;
+
+    Editor *editor = parent->editors().value(path);
+    if(editor)
+        editor->addSearchMatches(matches);
+
+    auto group = new QTreeWidgetItem;
+    lstResults->addTopLevelItem(group);
+    group->setFirstColumnSpanned(true);
+    group->setText(0, QStringLiteral("%1 (%2)").arg(path.isEmpty() ? "<embedded script>" : QDir::cleanPath(path)).arg(matches.size()));
+    group->setFlags(Qt::ItemIsEnabled);
+
+    QList<QTreeWidgetItem*> items;
+    for(const auto &m : matches)
+    {
+        if(findAllState.shown + items.size() >= maxItems) break;
+        auto item = new QTreeWidgetItem(QStringList{QString::number(m.line + 1), m.preview});
+        item->setData(0, Qt::UserRole, m.start);
+        item->setData(0, Qt::UserRole + 1, m.length);
+        item->setData(0, Qt::UserRole + 2, path);
+        if(revision >= 0)
+            item->setData(0, Qt::UserRole + 3, revision);
+        items << item;
+    }
+    group->addChildren(items);
+    group->setExpanded(true);
+    findAllState.count += matches.size();
+    findAllState.shown += items.size();
+}
+
+void SearchAndReplacePanel::addFindAllResults(const QVector<SearchMatch> &matches)
+{
+    const int maxItems = 10000;
+
+    if(findAllState.editor)
+        findAllState.editor->addSearchMatches(matches);
+
+    QList<QTreeWidgetItem*> items;
+    for(const auto &m : matches)
+    {
+        if(findAllState.shown + items.size() >= maxItems) break;
+        auto item = new QTreeWidgetItem(QStringList{QString::number(m.line + 1), m.preview});
+        item->setData(0, Qt::UserRole, m.start);
+        item->setData(0, Qt::UserRole + 1, m.length);
+        items << item;
+    }
+    lstResults->addTopLevelItems(items);
+    findAllState.count += matches.size();
+    findAllState.shown += items.size();
+}
+
+void SearchAndReplacePanel::finishFindAll(bool ok)
+{
+    if(!ok && chkRegExp->isChecked())
+        parent->statusBar()->showMessage("Invalid regular expression.", 4000);
+    else if(findAllState.count == 0)
+        parent->statusBar()->showMessage("No occurrences found.", 4000);
+    else
+        parent->statusBar()->showMessage(QStringLiteral("%1 occurrences found.").arg(findAllState.count), 4000);
+
+    if(findAllState.shown < findAllState.count)
+    {
+        auto item = new QTreeWidgetItem(QStringList{"", QStringLiteral("(%1 more occurrences not shown)").arg(findAllState.count - findAllState.shown)});
+        item->setFlags(Qt::NoItemFlags);
+        lstResults->addTopLevelItem(item);
+    }
+}
+
+SearchOptions SearchAndReplacePanel::searchOptions() const
+{
+    // all the searches (find, replace, find all, replace all) go through
+    // finder.h, so that they match the same way:
+    SearchOptions opts;
+    opts.what = editFind->currentText();
+    opts.regExp = chkRegExp->isChecked();
+    opts.caseSensitive = chkCaseSens->isChecked();
+    return opts;
+}
+
+bool SearchAndReplacePanel::replace()
+{
+    QString with = editReplace->currentText();
+    if(editReplace->findText(with) == -1) editReplace->addItem(with);
+    return parent->activeEditor()->replaceMatch(searchOptions(), with);
+}
+
+void SearchAndReplacePanel::replaceAll()
+{
+    QString what = editFind->currentText();
+    if(editFind->findText(what) == -1) editFind->addItem(what);
+    QString with = editReplace->currentText();
+    if(editReplace->findText(with) == -1) editReplace->addItem(with);
+    int count = parent->activeEditor()->replaceAll(searchOptions(), with);
+    if(count < 0)
+        parent->statusBar()->showMessage("Invalid regular expression.", 4000);
+    else if(count == 0)
+        parent->statusBar()->showMessage("No occurrences found.", 4000);
+    else
+        parent->statusBar()->showMessage(QStringLiteral("%1 occurrences replaced.").arg(count), 4000);
 }
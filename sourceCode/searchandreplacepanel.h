@@ -2,8 +2,13 @@
 #define SEARCHANDREPLACEPANEL_H
 
 #include <QtWidgets>
+#include <atomic>
+#include <memory>
+
+#include "finder.h"
 
 class Dialog;
+class Editor;
 
 class SearchAndReplacePanel : public QWidget
 {
@@ -21,7 +26,20 @@ public slots:
 
 private slots:
     void find();
-    void replace();
+    void findAll();
+    void cancelFindAll();
+    bool replace();
+    void replaceAll();
+
+private:
+    SearchOptions searchOptions() const;
+    void startFindAll(Editor *editor, const SearchOptions &opts);
+    void startFindAllInFiles(const SearchOptions &opts);
+    void addFindAllResults(const QVector<SearchMatch> &matches);
+    // revision: of the buffer that was searched, -1 if searched on disk
+    void addFindAllResults(const QString &path, const QVector<SearchMatch> &matches, qint64 revision = -1);
+    void clearSearchMatches();
+    void finishFindAll(bool ok);
 
 signals:
     void shown();
@@ -34,10 +52,24 @@ private:
     QComboBox *editFind;
     QComboBox *editReplace;
     QToolButton *btnFind;
+    QToolButton *btnFindAll;
     QToolButton *btnReplace;
+    QToolButton *btnReplaceAll;
     QPushButton *btnClose;
     QCheckBox *chkRegExp;
     QCheckBox *chkCaseSens;
+    QCheckBox *chkAllFiles;
+    QTreeWidget *lstResults;
+    QTimer *findAllRestartTimer;
+    struct {
+        QPointer<Editor> editor;
+        SearchOptions opts;
+        std::shared_ptr<std::atomic<bool>> cancel;
+        quint64 generation {0};
+        int count {0};
+        int shown {0};
+        QMetaObject::Connection textChangedConnection;
+    } findAllState;
 
     friend class Dialog;
 };
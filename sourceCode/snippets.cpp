@@ -1,6 +1,7 @@
 #include "snippets.h"
 #include "dialog.h"
 #include "editor.h"
+#include "stats.h"
 #include <simPlusPlus/Lib.h>
 
 bool Snippet::changed() const
@@ -34,6 +35,8 @@ SnippetsLibrary::SnippetsLibrary()
 
 void SnippetsLibrary::load(const EditorOptions &opts)
 {
+    STATS_SCOPE("SnippetsLibrary::load");
+
     snippetGroups.clear();
 
     QStringList snippetLocations;
@@ -146,6 +149,22 @@ bool SnippetsLibrary::empty() const
     return true;
 }
 
+qint64 SnippetsLibrary::memoryUsage() const
+{
+    qint64 n = 0;
+    for(const auto &snippetGroup : snippetGroups)
+    {
+        n += ::memoryUsage(snippetGroup.name) + ::memoryUsage(snippetGroup.relDir);
+        for(const auto &snippet : snippetGroup.snippets)
+        {
+            // the content is shared with the menu action's slot:
+            n += ::memoryUsage(snippet.name) + ::memoryUsage(snippet.content) + ::memoryUsage(snippet.filePath);
+            n += sizeof(QAction) + 200;
+        }
+    }
+    return n;
+}
+
 void SnippetsLibrary::fillMenu(Dialog *parent, QMenu *menu) const
 {
     menu->clear();
@@ -170,3 +189,12 @@ void SnippetsLibrary::fillMenu(Dialog *parent, QMenu *menu) const
         }
     }
 }
+
+QVector<QPair<QString, Snippet>> SnippetsLibrary::snippets() const
+{
+    QVector<QPair<QString, Snippet>> ret;
+    for(const auto &snippetGroup : snippetGroups)
+        for(const auto &snippet : snippetGroup.snippets)
+            ret.append(qMakePair(snippetGroup.relDir != "." ? snippetGroup.name : QString(), snippet));
+    return ret;
+}
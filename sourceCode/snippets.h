@@ -39,7 +39,10 @@ private:
 public:
     bool changed() const;
     bool empty() const;
+    qint64 memoryUsage() const;
     void fillMenu(Dialog *parent, QMenu *menu) const;
+    // all the snippets, with the name of their group ("" for the top level)
+    QVector<QPair<QString, Snippet>> snippets() const;
 private:
     QMap<QString, SnippetGroup> snippetGroups;
 };
@@ -0,0 +1,97 @@
+#include "stats.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+static std::atomic<StatsCounter*> statsCounters {nullptr};
+
+StatsCounter::StatsCounter(const char *name)
+    : name(name)
+{
+    for(auto &b : buckets) b = 0;
+
+    // push onto the global (lock-free) list of counters:
+    next = statsCounters.load();
+    while(!statsCounters.compare_exchange_weak(next, this));
+}
+
+void StatsCounter::record(quint64 ns)
+{
+    count.fetch_add(1, std::memory_order_relaxed);
+    totalNs.fetch_add(ns, std::memory_order_relaxed);
+    quint64 m = maxNs.load(std::memory_order_relaxed);
+    while(ns > m && !maxNs.compare_exchange_weak(m, ns, std::memory_order_relaxed));
+    m = intervalMaxNs.load(std::memory_order_relaxed);
+    while(ns > m && !intervalMaxNs.compare_exchange_weak(m, ns, std::memory_order_relaxed));
+
+    // bucket i holds durations below 2^i microseconds:
+    quint64 us = ns / 1000;
+    int i = 0;
+    while(us > 0 && i < numBuckets - 1)
+    {
+        us >>= 1;
+        i++;
+    }
+    buckets[i].fetch_add(1, std::memory_order_relaxed);
+}
+
+void StatsCounter::reset()
+{
+    count = 0;
+    totalNs = 0;
+    maxNs = 0;
+    intervalMaxNs = 0;
+    for(auto &b : buckets) b = 0;
+}
+
+static double percentileUs(const quint64 *buckets, quint64 count, double p)
+{
+    // upper bound of the bucket containing the p-th percentile:
+    quint64 target = quint64(p * count), acc = 0;
+    for(int i = 0; i < StatsCounter::numBuckets; i++)
+    {
+        acc += buckets[i];
+        if(acc > target) return double(1ull << i);
+    }
+    return double(1ull << (StatsCounter::numBuckets - 1));
+}
+
+const char * statsTakeSlowest(quint64 *ns)
+{
+    const char *name = nullptr;
+    *ns = 0;
+    for(StatsCounter *c = statsCounters.load(); c; c = c->next)
+    {
+        quint64 m = c->intervalMaxNs.exchange(0, std::memory_order_relaxed);
+        if(m > *ns)
+        {
+            *ns = m;
+            name = c->name;
+        }
+    }
+    return name;
+}
+
+QString statsToJson(bool reset)
+{
+    QJsonObject ret;
+    for(StatsCounter *c = statsCounters.load(); c; c = c->next)
+    {
+        quint64 buckets[StatsCounter::numBuckets];
+        QJsonArray histogram;
+        for(int i = 0; i < StatsCounter::numBuckets; i++)
+            histogram.append(double(buckets[i] = c->buckets[i].load()));
+        quint64 count = c->count, totalNs = c->totalNs;
+        QJsonObject o;
+        o["count"] = double(count);
+        o["totalMs"] = totalNs / 1e6;
+        o["meanUs"] = count ? totalNs / 1e3 / count : 0.;
+        o["maxUs"] = c->maxNs / 1e3;
+        o["p50Us"] = count ? percentileUs(buckets, count, 0.50) : 0.;
+        o["p99Us"] = count ? percentileUs(buckets, count, 0.99) : 0.;
+        o["histogram"] = histogram;
+        ret[c->name] = o;
+        if(reset) c->reset();
+    }
+    return QString::fromUtf8(QJsonDocument(ret).toJson(QJsonDocument::Compact));
+}
@@ -0,0 +1,66 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include "trace.h"
+
+// lightweight, always-on instrumentation: a counter records how many times
+// a code path ran and a latency histogram (power-of-two microsecond buckets).
+// counters are lock-free and can be updated from any thread.
+// when tracing is enabled, each measured scope is also recorded as a span.
+class StatsCounter
+{
+public:
+    static const int numBuckets = 24;
+
+    StatsCounter(const char *name);
+    void record(quint64 ns);
+    void reset();
+
+    const char *name;
+    std::atomic<quint64> count {0};
+    std::atomic<quint64> totalNs {0};
+    std::atomic<quint64> maxNs {0};
+    std::atomic<quint64> intervalMaxNs {0};
+    std::atomic<quint64> buckets[numBuckets];
+    StatsCounter *next {nullptr};
+};
+
+class StatsScope
+{
+public:
+    inline StatsScope(StatsCounter &counter)
+        : counter(counter),
+          start(std::chrono::steady_clock::now())
+    {
+    }
+
+    inline ~StatsScope()
+    {
+        auto end = std::chrono::steady_clock::now();
+        counter.record(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        if(traceEnabled.load(std::memory_order_relaxed))
+            traceComplete(counter.name, start, end);
+    }
+
+private:
+    StatsCounter &counter;
+    std::chrono::steady_clock::time_point start;
+};
+
+// JSON object with one entry per counter
+QString statsToJson(bool reset = false);
+
+// the counter with the slowest single run since the previous call
+const char * statsTakeSlowest(quint64 *ns);
+
+#define STATS_CONCAT_(a, b) a##b
+#define STATS_CONCAT(a, b) STATS_CONCAT_(a, b)
+// measure the enclosing scope under the given (string literal) name:
+#define STATS_SCOPE(name) \
+    static StatsCounter STATS_CONCAT(statsCounter, __LINE__)(name); \
+    StatsScope STATS_CONCAT(statsScope, __LINE__)(STATS_CONCAT(statsCounter, __LINE__))
+
+#endif // STATS_H
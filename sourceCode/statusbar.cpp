@@ -1,5 +1,6 @@
 #include "statusbar.h"
 #include "dialog.h"
+#include "stats.h"
 
 StatusBar::StatusBar(Dialog *parent)
     : QStatusBar(parent),
@@ -8,6 +9,12 @@ StatusBar::StatusBar(Dialog *parent)
     addPermanentWidget(lblCursorPos = new QLabel("1:1"));
     lblCursorPos->setFrameStyle(QFrame::Panel | QFrame::Sunken);
     lblCursorPos->setFixedWidth(120);
+
+    addWidget(lblHud = new QLabel);
+    lblHud->setVisible(false);
+    hudTimer = new QTimer(this);
+    hudTimer->setInterval(1000);
+    connect(hudTimer, &QTimer::timeout, this, &StatusBar::updateHud);
 }
 
 StatusBar::~StatusBar()
@@ -23,3 +30,43 @@ void StatusBar::setSelectionInfo(int fromLine, int fromIndex, int toLine, int to
 {
     lblCursorPos->setText(QString("%1:%2-%3:%4 S").arg(fromLine + 1).arg(fromIndex + 1).arg(toLine + 1).arg(toIndex + 1));
 }
+
+void StatusBar::setHudVisible(bool v)
+{
+    lblHud->setVisible(v);
+    if(v)
+        hudTimer->start();
+    else
+        hudTimer->stop();
+}
+
+void StatusBar::recordKeyLatency(qint64 ns)
+{
+    // rolling window of the most recent samples:
+    const int windowSize = 256;
+    if(keyLatencies.size() < windowSize)
+        keyLatencies.append(ns);
+    else
+        keyLatencies[keyLatenciesNext] = ns;
+    keyLatenciesNext = (keyLatenciesNext + 1) % windowSize;
+}
+
+void StatusBar::updateHud()
+{
+    QString txt = "key\u2192paint: -";
+    if(!keyLatencies.isEmpty())
+    {
+        QVector<qint64> v(keyLatencies);
+        auto percentile = [&] (double p) {
+            auto nth = v.begin() + qMin(v.size() - 1, int(p * v.size()));
+            std::nth_element(v.begin(), nth, v.end());
+            return *nth / 1e6;
+        };
+        double p50 = percentile(0.50), p99 = percentile(0.99);
+        txt = QString("key\u2192paint p50: %1 ms, p99: %2 ms").arg(p50, 0, 'f', 1).arg(p99, 0, 'f', 1);
+    }
+    quint64 ns;
+    if(const char *slowest = statsTakeSlowest(&ns))
+        txt += QString(" | slowest: %1 (%2 ms)").arg(slowest).arg(ns / 1e6, 0, 'f', 1);
+    lblHud->setText(txt);
+}
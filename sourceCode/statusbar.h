@@ -15,10 +15,19 @@ public:
 
     void setCursorInfo(int line, int index);
     void setSelectionInfo(int fromLine, int fromIndex, int toLine, int toIndex);
+    void setHudVisible(bool v);
+    void recordKeyLatency(qint64 ns);
+
+private slots:
+    void updateHud();
 
 private:
     Dialog *parent;
     QLabel *lblCursorPos;
+    QLabel *lblHud;
+    QTimer *hudTimer;
+    QVector<qint64> keyLatencies;
+    int keyLatenciesNext {0};
 };
 
 #endif // STATUSBAR_H
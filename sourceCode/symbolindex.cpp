@@ -0,0 +1,386 @@
+#include "symbolindex.h"
+#include "common.h"
+#include "finder.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <algorithm>
+#include <cstring>
+
+// on-disk layout: header, file table, symbol table (sorted by name), strings
+struct IndexHeader
+{
+    char magic[8];
+    quint32 fileCount;
+    quint32 symbolCount;
+    quint32 filesOffset;
+    quint32 symbolsOffset;
+    quint32 stringsOffset;
+    quint32 stringsSize;
+};
+
+struct IndexFileEntry
+{
+    quint32 path;
+    quint32 pathLength;
+    qint64 lastModified;
+    qint64 size;
+    quint32 lang;
+    quint32 reserved;
+};
+
+struct IndexSymbolEntry
+{
+    quint32 name;
+    quint32 nameLength;
+    quint32 file;
+    quint32 line;
+};
+
+static const char indexMagic[8] = {'S', 'C', 'E', 'I', 'D', 'X', '0', '2'};
+
+enum IndexLang : quint32
+{
+    NoLang,
+    LuaLang,
+    PythonLang
+};
+
+static IndexLang indexLang(const QString &lang)
+{
+    if(lang == "lua") return LuaLang;
+    if(lang == "python") return PythonLang;
+    return NoLang;
+}
+
+// true if file (a clean path) would be listed by scriptSearchPathFiles()
+static bool inSearchPath(const QString &file, const QVector<QString> &scriptSearchPath)
+{
+    for(const auto &pattern : scriptSearchPath)
+    {
+        int q = pattern.indexOf('?');
+        if(q == -1) continue;
+        int slash = pattern.lastIndexOf('/', q);
+        if(slash == -1) continue;
+        QString dir = QDir::cleanPath(pattern.left(slash));
+        if(file.startsWith(dir + "/") && file.endsWith(pattern.mid(q + 1)))
+            return true;
+    }
+    return false;
+}
+
+static const IndexHeader * validIndex(const uchar *data, qint64 size)
+{
+    if(!data || size < qint64(sizeof(IndexHeader))) return nullptr;
+    auto h = reinterpret_cast<const IndexHeader *>(data);
+    if(memcmp(h->magic, indexMagic, sizeof(indexMagic)) != 0) return nullptr;
+    if(h->filesOffset + qint64(h->fileCount) * sizeof(IndexFileEntry) > size) return nullptr;
+    if(h->symbolsOffset + qint64(h->symbolCount) * sizeof(IndexSymbolEntry) > size) return nullptr;
+    if(h->stringsOffset + qint64(h->stringsSize) > size) return nullptr;
+    return h;
+}
+
+struct IndexedFile
+{
+    QString path;
+    qint64 lastModified;
+    qint64 size;
+    quint32 lang;
+    QVector<QPair<QByteArray, int>> symbols;
+};
+
+static QByteArray serializeIndex(const QVector<IndexedFile> &files)
+{
+    struct Symbol
+    {
+        QByteArray name;
+        quint32 file;
+        quint32 line;
+    };
+    std::vector<Symbol> symbols;
+    QVector<IndexFileEntry> fileEntries;
+    QByteArray strings;
+
+    for(int i = 0; i < files.size(); i++)
+    {
+        QByteArray path = files[i].path.toUtf8();
+        fileEntries.append({quint32(strings.size()), quint32(path.size()), files[i].lastModified, files[i].size, files[i].lang, 0});
+        strings.append(path);
+        for(const auto &s : files[i].symbols)
+            symbols.push_back({s.first, quint32(i), quint32(s.second)});
+    }
+    std::sort(symbols.begin(), symbols.end(), [] (const Symbol &a, const Symbol &b) {
+        return a.name < b.name;
+    });
+    QVector<IndexSymbolEntry> symbolEntries;
+    symbolEntries.reserve(int(symbols.size()));
+    for(const auto &s : symbols)
+    {
+        symbolEntries.append({quint32(strings.size()), quint32(s.name.size()), s.file, s.line});
+        strings.append(s.name);
+    }
+
+    IndexHeader h;
+    memcpy(h.magic, indexMagic, sizeof(indexMagic));
+    h.fileCount = fileEntries.size();
+    h.symbolCount = symbolEntries.size();
+    h.filesOffset = sizeof(IndexHeader);
+    h.symbolsOffset = h.filesOffset + h.fileCount * sizeof(IndexFileEntry);
+    h.stringsOffset = h.symbolsOffset + h.symbolCount * sizeof(IndexSymbolEntry);
+    h.stringsSize = strings.size();
+
+    QByteArray data;
+    data.reserve(h.stringsOffset + h.stringsSize);
+    data.append(reinterpret_cast<const char *>(&h), sizeof(h));
+    data.append(reinterpret_cast<const char *>(fileEntries.constData()), fileEntries.size() * sizeof(IndexFileEntry));
+    data.append(reinterpret_cast<const char *>(symbolEntries.constData()), symbolEntries.size() * sizeof(IndexSymbolEntry));
+    data.append(strings);
+    return data;
+}
+
+static bool parseFile(const QFileInfo &info, IndexedFile &result)
+{
+    EditorOptions opts;
+    if(info.suffix() == "lua")
+        opts.lang = "lua";
+    else if(info.suffix() == "py")
+        opts.lang = "python";
+    else
+        return false;
+
+    QFile f(info.filePath());
+    if(!f.open(QIODevice::ReadOnly)) return false;
+    QString code = QString::fromUtf8(f.readAll());
+    f.close();
+
+    QVector<QString> names;
+    QVector<int> pos;
+    getFunctionDefs(opts, code, names, pos);
+
+    result.path = info.filePath();
+    result.lastModified = info.lastModified().toMSecsSinceEpoch();
+    result.size = info.size();
+    result.lang = indexLang(opts.lang);
+    result.symbols.clear();
+    int line = 0, lineCountedTo = 0;
+    for(int i = 0; i < names.size(); i++)
+    {
+        // positions are in ascending order, so lines can be counted incrementally:
+        for(; lineCountedTo < pos[i]; lineCountedTo++)
+            if(code.at(lineCountedTo) == '\n')
+                line++;
+        QString name = SymbolIndex::symbolName(names[i]);
+        result.symbols.append(qMakePair(name.toUtf8(), line));
+        int sep = qMax(name.lastIndexOf('.'), name.lastIndexOf(':'));
+        if(sep >= 0)
+            result.symbols.append(qMakePair(name.mid(sep + 1).toUtf8(), line));
+    }
+    return true;
+}
+
+static bool buildIndex(const QVector<QString> &searchPath, const QString &indexPath, const QString &outputPath)
+{
+    // load the previous index, to skip files that have not changed:
+    QHash<QString, IndexedFile> previous;
+    QFile old(indexPath);
+    if(old.open(QIODevice::ReadOnly))
+    {
+        QByteArray oldData = old.readAll();
+        old.close();
+        auto data = reinterpret_cast<const uchar *>(oldData.constData());
+        if(auto h = validIndex(data, oldData.size()))
+        {
+            auto fileEntries = reinterpret_cast<const IndexFileEntry *>(data + h->filesOffset);
+            auto symbolEntries = reinterpret_cast<const IndexSymbolEntry *>(data + h->symbolsOffset);
+            auto strings = reinterpret_cast<const char *>(data + h->stringsOffset);
+            QVector<IndexedFile> files(h->fileCount);
+            for(quint32 i = 0; i < h->fileCount; i++)
+            {
+                files[i].path = QString::fromUtf8(strings + fileEntries[i].path, fileEntries[i].pathLength);
+                files[i].lastModified = fileEntries[i].lastModified;
+                files[i].size = fileEntries[i].size;
+                files[i].lang = fileEntries[i].lang;
+            }
+            for(quint32 i = 0; i < h->symbolCount; i++)
+            {
+                const auto &s = symbolEntries[i];
+                if(s.file < h->fileCount)
+                    files[s.file].symbols.append(qMakePair(QByteArray(strings + s.name, s.nameLength), int(s.line)));
+            }
+            for(const auto &f : files)
+                previous[f.path] = f;
+        }
+    }
+
+    // (files no longer in the search paths are dropped)
+    QStringList paths = scriptSearchPathFiles(searchPath);
+
+    QVector<IndexedFile> files;
+    for(const auto &path : paths)
+    {
+        QFileInfo info(path);
+        if(!info.isFile()) continue;
+        auto it = previous.constFind(path);
+        if(it != previous.constEnd() && it->lastModified == info.lastModified().toMSecsSinceEpoch() && it->size == info.size())
+        {
+            files.append(*it);
+            continue;
+        }
+        IndexedFile f;
+        if(parseFile(info, f))
+            files.append(f);
+    }
+
+    QSaveFile out(outputPath);
+    if(!out.open(QIODevice::WriteOnly)) return false;
+    QByteArray data = serializeIndex(files);
+    if(out.write(data) != data.size()) return false;
+    return out.commit();
+}
+
+SymbolIndex * SymbolIndex::instance()
+{
+    static SymbolIndex *index = new SymbolIndex;
+    return index;
+}
+
+SymbolIndex::SymbolIndex()
+{
+    QDir cacheDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    cacheDir.mkpath(".");
+    indexPath_ = cacheDir.filePath("simCodeEditor-symbols.idx");
+    mappedPath_ = indexPath_;
+    map();
+}
+
+SymbolIndex::~SymbolIndex()
+{
+    unmap();
+    if(mappedPath_ != indexPath_)
+        QFile::remove(mappedPath_);
+}
+
+bool SymbolIndex::map()
+{
+    file_.setFileName(mappedPath_);
+    if(!file_.open(QIODevice::ReadOnly)) return false;
+    size_ = file_.size();
+    data_ = file_.map(0, size_);
+    if(!validIndex(data_, size_))
+    {
+        unmap();
+        return false;
+    }
+    return true;
+}
+
+void SymbolIndex::unmap()
+{
+    if(data_) file_.unmap(const_cast<uchar *>(data_));
+    data_ = nullptr;
+    size_ = 0;
+    file_.close();
+}
+
+void SymbolIndex::update(const QVector<QString> &scriptSearchPath)
+{
+    bool newPaths = false;
+    for(const auto &path : scriptSearchPath)
+    {
+        if(!searchPath_.contains(path))
+        {
+            searchPath_ << path;
+            newPaths = true;
+        }
+    }
+
+    if(building_)
+    {
+        pending_ = pending_ || newPaths;
+        return;
+    }
+
+    // rescan at most once a minute unless new search paths appear:
+    if(!newPaths && lastBuild_.isValid() && lastBuild_.elapsed() < 60000)
+        return;
+
+    startBuild();
+}
+
+void SymbolIndex::startBuild()
+{
+    building_ = true;
+    lastBuild_.start();
+    QVector<QString> searchPath = searchPath_;
+    QString previousPath = mappedPath_;
+    // other instances may be building at the same time:
+    QString outputPath = QStringLiteral("%1.%2.new").arg(indexPath_).arg(QCoreApplication::applicationPid());
+    QThreadPool::globalInstance()->start([=] {
+        bool ok = buildIndex(searchPath, previousPath, outputPath);
+        QMetaObject::invokeMethod(this, [=] { finishBuild(ok, outputPath); }, Qt::QueuedConnection);
+    });
+}
+
+void SymbolIndex::finishBuild(bool ok, const QString &outputPath)
+{
+    building_ = false;
+
+    if(ok)
+    {
+        // the mapping must be released before the file can be replaced:
+        unmap();
+        if(mappedPath_ != indexPath_)
+            QFile::remove(mappedPath_);
+        // this fails if another instance has the shared index mapped (on
+        // Windows), or has just replaced it:
+        QFile::remove(indexPath_);
+        mappedPath_ = QFile::rename(outputPath, indexPath_) ? indexPath_ : outputPath;
+        map();
+    }
+
+    if(pending_)
+    {
+        pending_ = false;
+        startBuild();
+    }
+}
+
+QVector<SymbolLocation> SymbolIndex::lookup(const QString &name, const QString &lang, const QVector<QString> &scriptSearchPath) const
+{
+    QVector<SymbolLocation> ret;
+    auto h = validIndex(data_, size_);
+    if(!h || name.isEmpty()) return ret;
+
+    auto fileEntries = reinterpret_cast<const IndexFileEntry *>(data_ + h->filesOffset);
+    auto symbolEntries = reinterpret_cast<const IndexSymbolEntry *>(data_ + h->symbolsOffset);
+    auto strings = reinterpret_cast<const char *>(data_ + h->stringsOffset);
+    auto nameOf = [=] (const IndexSymbolEntry &s) {
+        return QByteArray::fromRawData(strings + s.name, s.nameLength);
+    };
+
+    QByteArray key = name.toUtf8();
+    auto end = symbolEntries + h->symbolCount;
+    auto it = std::lower_bound(symbolEntries, end, key, [&] (const IndexSymbolEntry &s, const QByteArray &k) {
+        return nameOf(s) < k;
+    });
+    for(; it != end && nameOf(*it) == key; ++it)
+    {
+        if(it->file >= h->fileCount) continue;
+        const auto &f = fileEntries[it->file];
+        if(f.lang != indexLang(lang)) continue;
+        QString path = QString::fromUtf8(strings + f.path, f.pathLength);
+        if(!inSearchPath(path, scriptSearchPath)) continue;
+        ret.append({path, int(it->line)});
+    }
+    return ret;
+}
+
+QString SymbolIndex::symbolName(const QString &functionDef)
+{
+    int paren = functionDef.indexOf('(');
+    return (paren >= 0 ? functionDef.left(paren) : functionDef).trimmed();
+}
@@ -0,0 +1,56 @@
+#ifndef SYMBOLINDEX_H
+#define SYMBOLINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QFile>
+#include <QElapsedTimer>
+
+struct SymbolLocation
+{
+    QString file;
+    int line;
+};
+
+// index of the function definitions found in the files of the script
+// search paths. the index is built on a worker thread and persisted to a
+// memory-mapped file in the cache directory, so that later sessions start
+// with a warm index. only files whose modification time or size changed
+// are parsed again. the index file is shared by all the running instances:
+// each writes its own temporary file, and replaces the shared one if it
+// can, or else keeps using its own until the next build.
+class SymbolIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    static SymbolIndex * instance();
+
+    void update(const QVector<QString> &scriptSearchPath);
+    // definitions of name in files of the given language, which are in
+    // (one of the patterns of) the given script search path
+    QVector<SymbolLocation> lookup(const QString &name, const QString &lang, const QVector<QString> &scriptSearchPath) const;
+
+    static QString symbolName(const QString &functionDef);
+
+private:
+    SymbolIndex();
+    virtual ~SymbolIndex();
+    bool map();
+    void unmap();
+    void startBuild();
+    void finishBuild(bool ok, const QString &outputPath);
+
+    QString indexPath_;     // shared by all the instances
+    QString mappedPath_;    // indexPath_, or this instance's own build
+    QFile file_;
+    const uchar *data_ {nullptr};
+    qint64 size_ {0};
+    QVector<QString> searchPath_;
+    bool building_ {false};
+    bool pending_ {false};
+    QElapsedTimer lastBuild_;
+};
+
+#endif // SYMBOLINDEX_H
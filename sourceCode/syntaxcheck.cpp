@@ -0,0 +1,24 @@
+#include "syntaxcheck.h"
+#include "luasyntax.h"
+#include "pythonsyntax.h"
+#include "jsonsyntax.h"
+
+QVector<Diagnostic> SyntaxChecker::run(const QByteArray &text, QVector<OutlineEntry> *outline)
+{
+    QMutexLocker locker(&mutex_);
+    QVector<Diagnostic> diagnostics = check(text);
+    if(outline && providesOutline())
+        *outline = this->outline();
+    return diagnostics;
+}
+
+SyntaxChecker * SyntaxChecker::create(const QString &lang)
+{
+    if(lang == "lua")
+        return new LuaSyntaxChecker;
+    if(lang == "python")
+        return new PythonSyntaxChecker;
+    if(lang == "json")
+        return new JsonSyntaxChecker;
+    return nullptr;
+}
@@ -0,0 +1,82 @@
+#ifndef SYNTAXCHECK_H
+#define SYNTAXCHECK_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <QHash>
+
+struct Diagnostic
+{
+    enum Severity
+    {
+        Error,
+        Warning
+    };
+    Severity severity {Error};
+    int start;      // byte offset in the (UTF-8) document
+    int length;     // length in bytes
+    int line;       // 0-based line number
+    QString message;
+};
+
+// entry of the outline of a document (function navigator)
+struct OutlineEntry
+{
+    QString name;
+    int line;       // 0-based line number
+    int depth {0};  // number of enclosing definitions
+};
+
+// syntax checker of a language. each editor owns an instance, which keeps
+// the results of the pieces of text it checked last, so that only the
+// pieces that changed need to be checked again. run() is called from the
+// analysis pool, and is serialized per instance.
+class SyntaxChecker
+{
+public:
+    virtual ~SyntaxChecker() {}
+
+    // if outline is given and the checker provides one, it is filled too
+    QVector<Diagnostic> run(const QByteArray &text, QVector<OutlineEntry> *outline = nullptr);
+
+    // true if checking also builds the outline of the document
+    virtual bool providesOutline() const { return false; }
+
+    // true if the checker is incremental enough to run on huge files
+    virtual bool supportsHugeFiles() const { return false; }
+
+    // returns nullptr if there is no checker for the language
+    static SyntaxChecker * create(const QString &lang);
+
+protected:
+    virtual QVector<Diagnostic> check(const QByteArray &text) = 0;
+    virtual QVector<OutlineEntry> outline() const { return {}; }
+
+private:
+    QMutex mutex_;
+};
+
+// helpers for the checkers, which work on the UTF-8 bytes of a document:
+
+inline bool isNewline(char c)
+{
+    return c == '\n' || c == '\r';
+}
+
+// skip the newline sequence (\n, \r, \r\n or \n\r) at i
+inline int skipNewline(const char *s, int n, int i)
+{
+    char c = s[i++];
+    if(i < n && isNewline(s[i]) && s[i] != c) i++;
+    return i;
+}
+
+// hash of a piece of text, used as key of the caches of the checkers
+inline size_t chunkHash(const char *s, int len)
+{
+    return qHashBits(s, len, 0) ^ size_t(len);
+}
+
+#endif // SYNTAXCHECK_H
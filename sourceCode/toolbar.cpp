@@ -2,6 +2,8 @@
 #include "dialog.h"
 #include "editor.h"
 #include "searchandreplacepanel.h"
+#include "stats.h"
+#include "idlescheduler.h"
 
 class QComboBoxOpenFiles : public QComboBox
 {
@@ -18,24 +20,58 @@ public:
         painter.setPen(palette().color(QPalette::Text));
         QStyleOptionComboBox opt;
         initStyleOption(&opt);
-        int l = opt.currentText.length();
         int maxW = contentsRect().width() - 1.3 * contentsRect().height();
-        while(
-                fm.
+        int l = elidedLength(fm, opt.currentText, maxW);
+        if(l == 0 && !opt.currentText.isEmpty()) return;
+        opt.currentText = elideLeft(opt.currentText, l);
+        painter.drawComplexControl(QStyle::CC_ComboBox, opt);
+        if(l) painter.drawControl(QStyle::CE_ComboBoxLabel, opt);
+    }
+
+private:
+    static int textWidth(const QFontMetrics &fm, const QString &text)
+    {
+        return fm.
 #if QT_VERSION < QT_VERSION_CHECK(5, 11, 0)
-                   width
+                  width
 #else
-                   horizontalAdvance
+                  horizontalAdvance
 #endif
-                       (elideLeft(opt.currentText, l)) > maxW
-        )
+                      (text);
+    }
+
+    // length of the longest elided label that fits in maxW (0 if none),
+    // cached per width for the current text and font
+    int elidedLength(const QFontMetrics &fm, const QString &text, int maxW)
+    {
+        if(text != elideCache_.text || font() != elideCache_.font)
         {
-            if(--l == 0) return;
+            elideCache_.text = text;
+            elideCache_.font = font();
+            elideCache_.lengths.clear();
         }
-        opt.currentText = elideLeft(opt.currentText, l);
-        painter.drawComplexControl(QStyle::CC_ComboBox, opt);
-        if(l) painter.drawControl(QStyle::CE_ComboBoxLabel, opt);
+        auto it = elideCache_.lengths.constFind(maxW);
+        if(it != elideCache_.lengths.constEnd()) return *it;
+
+        // the label width grows with its length, so bisect the cut point:
+        int lo = 0, hi = text.length();
+        while(lo < hi)
+        {
+            int mid = (lo + hi + 1) / 2;
+            if(textWidth(fm, elideLeft(text, mid)) <= maxW)
+                lo = mid;
+            else
+                hi = mid - 1;
+        }
+        elideCache_.lengths.insert(maxW, lo);
+        return lo;
     }
+
+    struct {
+        QString text;
+        QFont font;
+        QHash<int, int> lengths;
+    } elideCache_;
 };
 
 inline bool isDarkMode(QWidget *w)
@@ -162,6 +198,8 @@ ToolBar::ToolBar(Dialog *parent)
     ICON(save);
     addAction(openFiles.actSave = new QAction(QIcon(save), "Save current file"));
     openFiles.combo = new QComboBoxOpenFiles;
+    openFiles.model = new OpenFilesModel(this);
+    openFiles.combo->setModel(openFiles.model);
     openFiles.combo->setMaximumWidth(300);
     openFiles.actCombo = addWidget(openFiles.combo);
     ICON(close);
@@ -176,54 +214,6 @@ ToolBar::~ToolBar()
 {
 }
 
-void getFunctionDefs(const EditorOptions &opts, const QString &code, QVector<QString> &names, QVector<int> &pos, const QString &re, std::function<QString(QRegularExpressionMatch)> n, std::function<int(QRegularExpressionMatch)> p)
-{
-    if(opts.lang != "lua" && opts.lang != "python") return;
-    QRegularExpression regexp(re);
-    auto i = regexp.globalMatch(code);
-    while(i.hasNext())
-    {
-        const auto &m = i.next();
-        names.append(n(m));
-        pos.append(p(m));
-    }
-}
-
-void getFunctionDefs(const EditorOptions &opts, const QString &code, QVector<QString> &names, QVector<int> &pos)
-{
-    if(opts.lang == "lua")
-    {
-        getFunctionDefs(opts, code, names, pos,
-            "("
-                "function\\s+([a-zA-Z0-9_.:]+)\\s*(\\([^)]*\\))"
-            "|" "([a-zA-Z0-9_.]+)\\s*=\\s*function\\s*(\\([^)]*\\))"
-            ")",
-            [&] (QRegularExpressionMatch m)
-            {
-                return m.captured(2) + m.captured(3) + m.captured(4) + m.captured(5);
-            },
-            [&] (QRegularExpressionMatch m)
-            {
-                return qMax(m.capturedStart(2), m.capturedStart(4));
-            }
-        );
-    }
-    else if(opts.lang == "python")
-    {
-        getFunctionDefs(opts, code, names, pos,
-            "def\\s+([a-zA-Z0-9_]+)\\s*(\\(.*\\))\\s*:\\s*",
-            [&] (QRegularExpressionMatch m)
-            {
-                return m.captured(1) + m.captured(2);
-            },
-            [&] (QRegularExpressionMatch m)
-            {
-                return m.capturedStart(1);
-            }
-        );
-    }
-}
-
 void ToolBar::setEditorOptions(const EditorOptions &opts)
 {
     actLang->setText(opts.lang);
@@ -231,9 +221,19 @@ void ToolBar::setEditorOptions(const EditorOptions &opts)
     actLang->setVisible(opts.lang != "none");
 }
 
+MemoryUsage ToolBar::memoryUsage() const
+{
+    MemoryUsage u;
+    u.snippets = snippetsLibrary.memoryUsage();
+    for(QAction *a : actions())
+        for(const QSize &s : a->icon().availableSizes())
+            u.pixmaps += s.width() * s.height() * 4;
+    return u;
+}
+
 void ToolBar::updateButtons()
 {
-    EditorOptions opts = parent->options();
+    STATS_SCOPE("ToolBar::updateButtons");
 
     auto activeEditor = parent->activeEditor();
     actUndo->setEnabled(activeEditor->isUndoAvailable());
@@ -248,35 +248,65 @@ void ToolBar::updateButtons()
     actShowSearchPanel->setChecked(parent->searchPanel()->isVisible());
 
     openFiles.actClose->setEnabled(!activeEditor->externalFile().isEmpty());
-    openFiles.actSave->setEnabled(activeEditor->needsSaving());
+    openFiles.actSave->setEnabled(activeEditor->needsSaving() && !activeEditor->isSaving());
+    if(activeEditor->saveError().isEmpty())
+        openFiles.actSave->setToolTip("Save current file");
+    else
+        openFiles.actSave->setToolTip(QStringLiteral("Save current file (last save failed: %1)").arg(activeEditor->saveError()));
 
-    int i = 0, sel = -1;
     bool obs = openFiles.combo->blockSignals(true);
-    openFiles.combo->clear();
-    const auto &editors = parent->editors();
-    for(auto path : editors.keys())
+    // (not on every key press: the sync walks all the editors)
+    if(openFilesChanged)
     {
-        QString name("<embedded script>");
-        if(!path.isEmpty()) name = QDir::cleanPath(path);
-        auto editor = editors[path];
-        if(editor->needsSaving()) name = "* " + name;
-        openFiles.combo->addItem(name, QVariant::fromValue(editor));
-        if(editor == parent->activeEditor()) sel = i;
-        i++;
+        openFiles.model->sync(parent->editors(), parent->unloadedFiles());
+        openFilesChanged = false;
     }
-    openFiles.combo->setCurrentIndex(sel);
+    int sel = openFiles.model->row(activeEditor->externalFile());
+    if(openFiles.combo->currentIndex() != sel)
+        openFiles.combo->setCurrentIndex(sel);
     openFiles.combo->blockSignals(obs);
-    openFiles.setVisible(editors.count() > 1);
+    openFiles.setVisible(openFiles.model->rowCount() > 1);
+
+    // the function navigator and the snippets library are refreshed in
+    // idle time (the former only if the text doesn't change meanwhile):
+    auto scheduler = IdleScheduler::instance();
+    scheduler->post(this, "funcNav", IdleScheduler::Normal, activeEditor, [this] {
+        updateFunctionNavigator();
+        return false;
+    });
+    scheduler->post(this, "snippets", IdleScheduler::Low, nullptr, [this] {
+        if(snippetsLibrary.changed())
+        {
+            snippetsLibrary.load(parent->options());
+            snippetsLibrary.fillMenu(parent, snippetLib.menu);
+            snippetLib.act->setVisible(!snippetsLibrary.empty());
+        }
+        return false;
+    });
+}
+
+void ToolBar::updateFunctionNavigator()
+{
+    STATS_SCOPE("ToolBar::updateFunctionNavigator");
+
+    // built by the editor (from the lexer styles, or by the syntax checker)
+    // as the document changes:
+    auto activeEditor = parent->activeEditor();
+    setFunctionNavigator(activeEditor->hasOutline() ? activeEditor->outline() : QVector<OutlineEntry>());
+}
+
+void ToolBar::setFunctionNavigator(const QVector<OutlineEntry> &outline)
+{
+    // outlines of large documents (e.g. JSON) can have many thousands of
+    // entries, more than a menu can reasonably show:
+    const int maxItems = 1000;
 
     funcNav.menu->clear();
-    QVector<QString> names;
-    QVector<int> pos;
-    getFunctionDefs(opts, parent->activeEditor()->text(), names, pos);
-    for(int i = 0; i < names.count(); i++)
+    for(int i = 0; i < outline.count() && i < maxItems; i++)
     {
-        int line, index;
-        parent->activeEditor()->lineIndexFromPosition(pos[i], &line, &index);
-        QAction *a = new QAction(names[i]);
+        int line = outline[i].line;
+        // nested definitions (local functions, methods) are indented:
+        QAction *a = new QAction(QString(4 * outline[i].depth, ' ') + outline[i].name);
         connect(a, &QAction::triggered, [this, line] {
             auto e = parent->activeEditor();
             e->ensureLineVisible(line);
@@ -285,12 +315,7 @@ void ToolBar::updateButtons()
         });
         funcNav.menu->addAction(a);
     }
-    funcNav.act->setEnabled(!names.isEmpty());
-
-    if(snippetsLibrary.changed())
-    {
-        snippetsLibrary.load(parent->options());
-        snippetsLibrary.fillMenu(parent, snippetLib.menu);
-        snippetLib.act->setVisible(!snippetsLibrary.empty());
-    }
+    if(outline.count() > maxItems)
+        funcNav.menu->addAction(QStringLiteral("(%1 more...)").arg(outline.count() - maxItems))->setEnabled(false);
+    funcNav.act->setEnabled(!outline.isEmpty());
 }
@@ -4,6 +4,8 @@
 #include <QtWidgets>
 
 #include "snippets.h"
+#include "openfilesmodel.h"
+#include "syntaxcheck.h"
 
 class Dialog;
 
@@ -20,6 +22,12 @@ public slots:
     void updateButtons();
 
 public:
+    MemoryUsage memoryUsage() const;
+    inline const SnippetsLibrary & snippets() const { return snippetsLibrary; }
+    // the set of open files, or the modified/saving state of one, changed:
+    // the open files combo is brought in sync at the next updateButtons()
+    inline void invalidateOpenFiles() { openFilesChanged = true; }
+
     QAction *actLang;
     QMenu *actLangMenu;
     QAction *actReload;
@@ -31,6 +39,7 @@ public:
     struct {
         QAction *actSave;
         QComboBox *combo;
+        OpenFilesModel *model;
         QAction *actCombo;
         QAction *actClose;
         inline void setVisible(bool v)
@@ -51,8 +60,12 @@ public:
     QAction *actCloseHelp;
 
 private:
+    void updateFunctionNavigator();
+    void setFunctionNavigator(const QVector<OutlineEntry> &outline);
+
     Dialog *parent;
     SnippetsLibrary snippetsLibrary;
+    bool openFilesChanged {true};
 };
 
 #endif // TOOLBAR_H
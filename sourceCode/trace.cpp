@@ -0,0 +1,200 @@
+#include "trace.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+std::atomic<bool> traceEnabled {false};
+
+struct TraceEvent
+{
+    const char *name;
+    quint64 ts;
+    quint64 dur;
+};
+
+// single producer (the owning thread), single consumer (the flush thread).
+// buffers are never freed: when its thread exits, a buffer is drained by
+// the flush thread, then reused by the next thread that needs one (the
+// threads of the pools expire when idle, and are created again later).
+struct TraceBuffer
+{
+    static const quint32 capacity = 1 << 16;
+
+    enum State
+    {
+        InUse,      // by its thread
+        Released,   // its thread has exited, events may be left
+        Free,       // drained, can be claimed by another thread
+        Claimed     // being set up for the thread that claimed it
+    };
+
+    TraceEvent events[capacity];
+    std::atomic<quint32> head {0};
+    std::atomic<quint32> tail {0};
+    std::atomic<quint64> dropped {0};
+    std::atomic<int> state {Claimed};
+    quint64 tid;
+    std::atomic<const char*> threadName;
+    // (reset by traceStart, as a thread can claim the buffer meanwhile)
+    std::atomic<bool> threadNameWritten {false};
+    TraceBuffer *next {nullptr};
+};
+
+// the buffer of a thread, released when the thread exits
+struct ThreadBuffer
+{
+    TraceBuffer *buffer {nullptr};
+
+    ~ThreadBuffer()
+    {
+        if(buffer) buffer->state.store(TraceBuffer::Released, std::memory_order_release);
+    }
+};
+
+static std::atomic<TraceBuffer*> traceBuffers {nullptr};
+static thread_local ThreadBuffer threadBuffer;
+static thread_local const char *threadName = "worker";
+static std::chrono::steady_clock::time_point traceEpoch;
+static FILE *traceFile = nullptr;
+static bool traceFirstEvent = true;
+static std::thread traceFlushThread;
+static std::mutex traceFlushMutex;
+static std::condition_variable traceFlushCond;
+static bool traceFlushQuit = false;
+
+static TraceBuffer * getThreadBuffer()
+{
+    if(!threadBuffer.buffer)
+    {
+        // reuse the buffer of an exited thread, or else add a new one:
+        TraceBuffer *b = traceBuffers.load();
+        for(; b; b = b->next)
+        {
+            int expected = TraceBuffer::Free;
+            if(b->state.compare_exchange_strong(expected, TraceBuffer::Claimed)) break;
+        }
+        if(!b)
+        {
+            b = new TraceBuffer;
+            b->next = traceBuffers.load();
+            while(!traceBuffers.compare_exchange_weak(b->next, b));
+        }
+        b->tid = quint64(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+        b->threadName = threadName;
+        b->threadNameWritten = false;
+        b->state.store(TraceBuffer::InUse, std::memory_order_release);
+        threadBuffer.buffer = b;
+    }
+    return threadBuffer.buffer;
+}
+
+static void traceWrite(const char *fmt, ...)
+{
+    if(!traceFirstEvent) std::fputs(",\n", traceFile);
+    traceFirstEvent = false;
+    va_list args;
+    va_start(args, fmt);
+    std::vfprintf(traceFile, fmt, args);
+    va_end(args);
+}
+
+static void traceFlush()
+{
+    qint64 pid = QCoreApplication::applicationPid();
+    for(TraceBuffer *b = traceBuffers.load(); b; b = b->next)
+    {
+        int state = b->state.load(std::memory_order_acquire);
+        if(state == TraceBuffer::Free || state == TraceBuffer::Claimed) continue;
+        if(!b->threadNameWritten)
+        {
+            traceWrite("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%lld,\"tid\":%llu,\"args\":{\"name\":\"%s\"}}", pid, b->tid, b->threadName.load());
+            b->threadNameWritten = true;
+        }
+        quint32 t = b->tail.load(std::memory_order_relaxed);
+        quint32 h = b->head.load(std::memory_order_acquire);
+        for(; t != h; t++)
+        {
+            const TraceEvent &e = b->events[t % TraceBuffer::capacity];
+            traceWrite("{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":%lld,\"tid\":%llu}", e.name, e.ts, e.dur, pid, b->tid);
+        }
+        b->tail.store(t, std::memory_order_release);
+        // (the thread wrote its last event before releasing the buffer)
+        if(state == TraceBuffer::Released)
+            b->state.store(TraceBuffer::Free, std::memory_order_release);
+    }
+    std::fflush(traceFile);
+}
+
+bool traceStart(const QString &path)
+{
+    if(traceEnabled) return true;
+
+    traceFile = std::fopen(path.toLocal8Bit().constData(), "w");
+    if(!traceFile) return false;
+    std::fputs("[\n", traceFile);
+    traceFirstEvent = true;
+    // each trace file needs the names of the threads again:
+    for(TraceBuffer *b = traceBuffers.load(); b; b = b->next)
+        b->threadNameWritten = false;
+    traceEpoch = std::chrono::steady_clock::now();
+    traceFlushQuit = false;
+    traceFlushThread = std::thread([] {
+        std::unique_lock<std::mutex> lock(traceFlushMutex);
+        while(!traceFlushQuit)
+        {
+            traceFlushCond.wait_for(lock, std::chrono::milliseconds(200));
+            traceFlush();
+        }
+    });
+    traceEnabled = true;
+    return true;
+}
+
+void traceStop()
+{
+    if(!traceEnabled) return;
+
+    traceEnabled = false;
+    {
+        std::lock_guard<std::mutex> lock(traceFlushMutex);
+        traceFlushQuit = true;
+    }
+    traceFlushCond.notify_one();
+    traceFlushThread.join();
+
+    quint64 dropped = 0;
+    for(TraceBuffer *b = traceBuffers.load(); b; b = b->next)
+        dropped += b->dropped;
+    if(dropped)
+        traceWrite("{\"name\":\"dropped events\",\"ph\":\"C\",\"ts\":0,\"pid\":%lld,\"args\":{\"dropped\":%llu}}", QCoreApplication::applicationPid(), dropped);
+    std::fputs("\n]\n", traceFile);
+    std::fclose(traceFile);
+    traceFile = nullptr;
+}
+
+void traceSetThreadName(const char *name)
+{
+    threadName = name;
+    if(threadBuffer.buffer)
+        threadBuffer.buffer->threadName = name;
+}
+
+void traceComplete(const char *name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    TraceBuffer *b = getThreadBuffer();
+    quint32 h = b->head.load(std::memory_order_relaxed);
+    if(h - b->tail.load(std::memory_order_acquire) >= TraceBuffer::capacity)
+    {
+        b->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TraceEvent &e = b->events[h % TraceBuffer::capacity];
+    e.name = name;
+    e.ts = std::chrono::duration_cast<std::chrono::microseconds>(start - traceEpoch).count();
+    e.dur = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    b->head.store(h + 1, std::memory_order_release);
+}
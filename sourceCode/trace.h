@@ -0,0 +1,20 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+#include <atomic>
+#include <chrono>
+
+// opt-in tracing in the Chrome trace-event format (chrome://tracing, Perfetto).
+// each thread records events into its own lock-free ring buffer; a background
+// thread drains the buffers and writes them to the trace file.
+
+extern std::atomic<bool> traceEnabled;
+
+bool traceStart(const QString &path);
+void traceStop();
+void traceSetThreadName(const char *name);
+// record a complete ("X") event; name must be a string with static lifetime
+void traceComplete(const char *name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+#endif // TRACE_H
@@ -0,0 +1,119 @@
+// checks the changes reported by ChangeTracker::diff, and that the line
+// hashes updated from edits match the hashes of the whole text
+
+#include "check.h"
+#include "changetracker.h"
+#include <QByteArray>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Case
+{
+    const char *base;
+    const char *current;
+    QVector<LineChange> expected;
+};
+
+bool sameChanges(const QVector<LineChange> &a, const QVector<LineChange> &b)
+{
+    if(a.size() != b.size()) return false;
+    for(int i = 0; i < a.size(); i++)
+        if(a[i].kind != b[i].kind || a[i].line != b[i].line || a[i].count != b[i].count)
+            return false;
+    return true;
+}
+
+void testDiff()
+{
+    const Case cases[] = {
+        {"a\nb\nc", "a\nb\nc", {}},
+        {"a\nb\nc", "a\nX\nc", {{LineChange::Modified, 1, 1}}},
+        {"a\nb\nc", "a\nb\nX\nc", {{LineChange::Added, 2, 1}}},
+        {"a\nb\nc", "a\nc", {{LineChange::Deleted, 1, 1}}},
+        {"a\nb\nc", "b\nc", {{LineChange::Deleted, 0, 1}}},
+        {"a\nb\nc", "a\nb", {{LineChange::Deleted, 2, 1}}},
+        // line endings are not part of the lines:
+        {"a\r\nb\r\nc", "a\nb\nc", {}},
+        // one change replacing a line by three, then a deleted line:
+        {"a\nb\nc\nd\ne", "a\nX\nY\nZ\nc\ne", {{LineChange::Modified, 1, 1}, {LineChange::Added, 2, 2}, {LineChange::Deleted, 5, 1}}},
+        // more lines removed than added:
+        {"a\nb\nc\nd", "a\nX\nd", {{LineChange::Modified, 1, 1}, {LineChange::Deleted, 2, 1}}},
+    };
+    for(const Case &c : cases)
+    {
+        QVector<LineChange> changes = ChangeTracker::diff(ChangeTracker::lineHashes(QByteArray(c.base)), ChangeTracker::lineHashes(QByteArray(c.current)));
+        CHECK_CTX(sameChanges(changes, c.expected), c.current);
+    }
+}
+
+// too many edits for Myers: the whole part between the common head and
+// tail is reported as changed
+void testDiffFallback()
+{
+    std::string base = "head\n", current = "head\n";
+    for(int i = 0; i < 3000; i++)
+    {
+        base += "a" + std::to_string(i) + "\n";
+        current += "b" + std::to_string(i) + "\n";
+    }
+    base += "tail";
+    current += "tail";
+    QVector<LineChange> changes = ChangeTracker::diff(ChangeTracker::lineHashes(QByteArray(base.data(), int(base.size()))), ChangeTracker::lineHashes(QByteArray(current.data(), int(current.size()))));
+    CHECK(sameChanges(changes, {{LineChange::Modified, 1, 3000}}));
+}
+
+// random line replacements, as the editor reports them
+void testReplaceLines()
+{
+    std::vector<std::string> lines;
+    for(int i = 0; i < 10000; i++)
+        lines.push_back("line " + std::to_string(i % 977));
+    auto join = [&lines] {
+        std::string s;
+        for(size_t i = 0; i < lines.size(); i++)
+            s += (i ? "\n" : "") + lines[i];
+        return QByteArray(s.data(), int(s.size()));
+    };
+
+    ChangeTracker tracker;
+    tracker.setBaseline(join());
+    tracker.setText(join());
+    std::mt19937 rng(1);
+    for(int edit = 0; edit < 200; edit++)
+    {
+        int line = rng() % lines.size();
+        int removed = std::min<int>(1 + rng() % 3, lines.size() - line);
+        int added = rng() % 4;
+        std::vector<std::string> newLines;
+        QVector<size_t> hashes;
+        for(int i = 0; i < added; i++)
+        {
+            newLines.push_back("new " + std::to_string(rng() % 50));
+            hashes.append(ChangeTracker::lineHash(newLines.back().data(), int(newLines.back().size())));
+        }
+        lines.erase(lines.begin() + line, lines.begin() + line + removed);
+        lines.insert(lines.begin() + line, newLines.begin(), newLines.end());
+        tracker.replaceLines(line, removed, hashes);
+    }
+    CHECK(tracker.lines() == ChangeTracker::lineHashes(join()));
+
+    // the changes account for the difference in number of lines:
+    int delta = 0;
+    for(const LineChange &c : ChangeTracker::diff(tracker.baseline(), tracker.lines()))
+        delta += c.kind == LineChange::Added ? c.count : c.kind == LineChange::Deleted ? -c.count : 0;
+    CHECK(tracker.baseline().size() + delta == tracker.lines().size());
+}
+
+} // namespace
+
+int main()
+{
+    testDiff();
+    testDiffFallback();
+    testReplaceLines();
+    std::fprintf(stderr, "%d failure(s)\n", checkFailures());
+    return checkFailures();
+}
@@ -0,0 +1,30 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <cstdio>
+
+// minimal assertions for the unit tests: a failed check is reported and
+// counted, and main() returns the number of failures (non-zero fails the
+// test in ctest)
+
+inline int & checkFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+inline bool checkResult(bool ok, const char *expr, const char *file, int line, const char *context)
+{
+    if(!ok)
+    {
+        std::fprintf(stderr, "%s:%d: check failed: %s%s%s\n", file, line, expr, *context ? " -- " : "", context);
+        checkFailures()++;
+    }
+    return ok;
+}
+
+#define CHECK(expr) checkResult(bool(expr), #expr, __FILE__, __LINE__, "")
+// with a description of the case being checked:
+#define CHECK_CTX(expr, context) checkResult(bool(expr), #expr, __FILE__, __LINE__, context)
+
+#endif // CHECK_H
@@ -0,0 +1,87 @@
+// checks the ranking of FuzzyIndex::match, and that the prefilter keeps
+// every candidate the query is a subsequence of
+
+#include "check.h"
+#include "fuzzymatch.h"
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <string>
+
+namespace {
+
+const char *names[] = {
+    "sim.getObject",
+    "sim.getObjectPosition",
+    "sim.setObjectPosition",
+    "getObjectHandle",
+    "helper12(a, b)",
+    "/home/user/scripts/robot.lua",
+    "sysCall_init",
+    "sysCall_actuation",
+    "sim.getSimulationTime",
+    "simGetObject",
+    "gop",
+};
+
+QStringList matches(const FuzzyIndex &index, const QString &query, int limit)
+{
+    QStringList result;
+    for(int i : index.match(query, limit))
+        result << index.text(i);
+    return result;
+}
+
+void testRanking()
+{
+    FuzzyIndex index;
+    for(const char *name : names)
+        index.add(name);
+
+    // exact match first, then word starts before scattered characters:
+    CHECK(matches(index, "gop", 10) == QStringList({"gop", "sim.getObjectPosition"}));
+    CHECK(matches(index, "sgo", 10) == QStringList({"simGetObject", "sim.getObject", "sim.getObjectPosition", "sim.getSimulationTime"}));
+    CHECK(matches(index, "scact", 10) == QStringList({"sysCall_actuation"}));
+    CHECK(matches(index, "robot", 10) == QStringList({"/home/user/scripts/robot.lua"}));
+    // case and spaces of the query are ignored:
+    CHECK(matches(index, "GObj Pos", 10) == QStringList({"sim.getObjectPosition"}));
+    CHECK(matches(index, "xyz", 10).isEmpty());
+    // at most limit, best first:
+    CHECK(matches(index, "sgo", 2) == QStringList({"simGetObject", "sim.getObject"}));
+    // all candidates in order for an empty query:
+    CHECK(matches(index, "", 3) == QStringList({"sim.getObject", "sim.getObjectPosition", "sim.setObjectPosition"}));
+}
+
+bool isSubsequence(const QByteArray &query, const QByteArray &text)
+{
+    int j = 0;
+    for(int i = 0; i < text.size() && j < query.size(); i++)
+        if(text[i] == query[j]) j++;
+    return j == query.size();
+}
+
+void testPrefilter()
+{
+    FuzzyIndex index;
+    index.reserve(5000, 5000 * 32);
+    for(int i = 0; i < 5000; i++)
+        index.add(QStringLiteral("module%1.function_%2_handler(a, b)").arg(i % 97).arg(i));
+
+    for(const char *query : {"m5fh", "function_4999", "hndlr", "mod", "zzz", "9_h"})
+    {
+        int expected = 0;
+        for(int i = 0; i < index.size(); i++)
+            expected += isSubsequence(query, index.text(i).toUtf8().toLower());
+        CHECK_CTX(index.match(query, index.size()).size() == expected, query);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    testRanking();
+    testPrefilter();
+    std::fprintf(stderr, "%d failure(s)\n", checkFailures());
+    return checkFailures();
+}
@@ -0,0 +1,85 @@
+// checks the diagnostics of the JSON checker (offsets, lines and messages)
+// on valid and invalid snippets, and that the incremental scan gives the
+// same results as a full scan after random edits
+
+#include "syntaxcases.h"
+#include <random>
+#include <string>
+
+namespace {
+
+const SyntaxCase cases[] = {
+    {"{\"a\": 1, \"b\": [1, 2.5e-3, -0, true, null], \"c\": {\"d\": {\"e\": [ {\"f\": {}} ]}}}", 0, 0, 0, nullptr},
+    {"[1, 2,]", 0, 6, 1, "unexpected ']', expected a value"},
+    {"{\"a\" 1}", 0, 5, 1, "unexpected '1', expected ':'"},
+    {"{\"a\": 01}", 0, 6, 2, "invalid number '01'"},
+    {"{\"a\": \"x\ny\"}", 0, 6, 2, "unterminated string"},
+    {"{\"a\": \"\\q\"}", 0, 7, 2, "invalid escape sequence"},
+    {"{\"a\": [1, 2}", 0, 11, 1, "unexpected '}', expected ',' or ']'"},
+    {"{\"a\": {\n\"b\": 1\n", 0, 6, 1, "'{' was never closed"},
+    {"{} x", 0, 3, 1, "unexpected 'x', expected end of document"},
+};
+
+bool sameOutline(const QVector<OutlineEntry> &a, const QVector<OutlineEntry> &b)
+{
+    if(a.size() != b.size()) return false;
+    for(int i = 0; i < a.size(); i++)
+        if(a[i].name != b[i].name || a[i].line != b[i].line || a[i].depth != b[i].depth)
+            return false;
+    return true;
+}
+
+// random edits on a document larger than the checkpoint interval of the
+// JSON checker: the incremental scan must match a scan from scratch
+void testJsonIncremental()
+{
+    std::string doc = "{\n  \"objects\": [\n";
+    for(int i = 0; i < 2000; i++)
+        doc += "    {\"name\": \"obj" + std::to_string(i) + "\", \"pose\": {\"p\": [1, 2, 3], \"q\": [0, 0, 0, 1]}, \"tags\": [\"a\", \"b\"]},\n";
+    doc += "    {}\n  ],\n  \"meta\": {\"version\": 2}\n}\n";
+    const std::string original = doc;
+
+    const char *snippets[] = {"{", "}", "[", "]", ",", ":", "\"k\"", "\"k\": 1, ", "1", "\n", " ", "\"", "{\"a\": [1, 2]}, ", "null"};
+    std::mt19937 rng(12345);
+    std::unique_ptr<SyntaxChecker> incremental(SyntaxChecker::create("json"));
+    incremental->run(QByteArray(doc.data(), int(doc.size())));
+    for(int edit = 0; edit < 300; edit++)
+    {
+        size_t pos = rng() % (doc.size() + 1);
+        std::string what;
+        if(rng() % 3 == 0)
+        {
+            size_t len = std::min<size_t>(rng() % 8 + 1, doc.size() - pos);
+            what = "erase " + std::to_string(len) + " at " + std::to_string(pos);
+            doc.erase(pos, len);
+        }
+        else
+        {
+            const char *s = snippets[rng() % (sizeof(snippets) / sizeof(snippets[0]))];
+            what = std::string("insert ") + s + " at " + std::to_string(pos);
+            doc.insert(pos, s);
+        }
+        QByteArray text(doc.data(), int(doc.size()));
+        QVector<OutlineEntry> incrementalOutline, fullOutline;
+        QVector<Diagnostic> a = incremental->run(text, &incrementalOutline);
+        std::unique_ptr<SyntaxChecker> full(SyntaxChecker::create("json"));
+        QVector<Diagnostic> b = full->run(text, &fullOutline);
+        what = "edit " + std::to_string(edit) + ": " + what;
+        CHECK_CTX(sameDiagnostics(a, b), what.c_str());
+        CHECK_CTX(sameOutline(incrementalOutline, fullOutline), what.c_str());
+        // start again from a valid document from time to time, as the
+        // scan stops at the first error:
+        if(edit % 20 == 19)
+            doc = original;
+    }
+}
+
+} // namespace
+
+int main()
+{
+    checkCases("json", cases);
+    testJsonIncremental();
+    std::fprintf(stderr, "%d failure(s)\n", checkFailures());
+    return checkFailures();
+}
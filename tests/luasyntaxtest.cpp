@@ -0,0 +1,29 @@
+// checks the diagnostics of the Lua syntax checker (offsets, lines and
+// messages) on valid and invalid snippets
+
+#include "syntaxcases.h"
+
+namespace {
+
+const SyntaxCase cases[] = {
+    {"local x = 1\nprint(x)\n", 0, 0, 0, nullptr},
+    {"local t = {a=1, [2]=3, 4; f=function(...) return ... end}\n", 0, 0, 0, nullptr},
+    {"x = [[\nlong\n]] .. 'a\\z\n  b'\n--[==[\ncomment\n]==]\ny = 0x1p4 + 3.5e-2 + .5\n", 0, 0, 0, nullptr},
+    {"x = 1\n+ 2\n", 0, 0, 0, nullptr},
+    {"goto done\n::done::\n", 0, 0, 0, nullptr},
+    {"function foo()\n  print(1\nend\n", 2, 25, 3, "')' expected (to close '(' at line 2) near 'end'"},
+    {"function foo()\n  if x then\n    y = 1\n\nx = 2\n", 5, 44, 0, "'end' expected (to close 'if' at line 2) near <eof>"},
+    {"return 1\nx = 2\n", 1, 9, 1, "'<eof>' expected near 'x'"},
+    {"local s = \"abc\nx=1\n", 0, 10, 4, "unfinished string near '\"abc'"},
+    {"x = 3..2\n", 0, 4, 4, "malformed number near '3..2'"},
+    {"f() = 1\n", 0, 4, 1, "syntax error near '='"},
+};
+
+} // namespace
+
+int main()
+{
+    checkCases("lua", cases);
+    std::fprintf(stderr, "%d failure(s)\n", checkFailures());
+    return checkFailures();
+}
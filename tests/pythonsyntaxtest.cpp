@@ -0,0 +1,36 @@
+// checks the diagnostics of the Python syntax checker (offsets, lines and
+// messages) on valid and invalid snippets
+
+#include "syntaxcases.h"
+
+namespace {
+
+const SyntaxCase cases[] = {
+    {"import os\n\ndef f(a, b=1):\n    return a + b\n\nclass A(object):\n    def m(self):\n        pass\n", 0, 0, 0, nullptr},
+    {"if x: pass\nelse: pass\n", 0, 0, 0, nullptr},
+    {"s = rb'''ab\nc''' + f\"x{1}\"\nx = \\\n  1\n", 0, 0, 0, nullptr},
+    {"def f():\nreturn 1\n", 0, 7, 1, "expected an indented block after function definition"},
+    {"if x:\n    y = 1\n      z = 2\n", 2, 16, 6, "unexpected indent"},
+    {"if x:\n        y = 1\n    z = 2\n", 2, 20, 4, "unindent does not match any outer indentation level"},
+    {"x = (1,\n  2]\n", 1, 11, 1, "closing parenthesis ']' does not match opening parenthesis '('"},
+    {"x = 1)\n", 0, 5, 1, "unmatched ')'"},
+    {"s = 'abc\nx = 1\n", 0, 4, 4, "unterminated string literal"},
+    {"if x\n    pass\n", 0, 3, 1, "expected ':'"},
+    {"    x = 1\n", 0, 0, 4, "unexpected indent"},
+    // match and case are soft keywords:
+    {"match command.split():\n    case [action]:\n        pass\n    case [action, obj]:\n        pass\n    case _:\n        pass\n", 0, 0, 0, nullptr},
+    {"match = re.match(r'x', s)\nif match:\n    pass\n", 0, 0, 0, nullptr},
+    {"case: int = 0\nmatch(x)\n", 0, 0, 0, nullptr},
+    {"match x:\ncase 1:\n    pass\n", 0, 7, 1, "expected an indented block after 'match' statement"},
+    {"match x:\n    case 1:\n    pass\n", 1, 19, 1, "expected an indented block after 'case' statement"},
+    {"match = 1\n    y = 2\n", 1, 10, 4, "unexpected indent"},
+};
+
+} // namespace
+
+int main()
+{
+    checkCases("python", cases);
+    std::fprintf(stderr, "%d failure(s)\n", checkFailures());
+    return checkFailures();
+}
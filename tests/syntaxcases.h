@@ -0,0 +1,57 @@
+#ifndef SYNTAXCASES_H
+#define SYNTAXCASES_H
+
+#include "check.h"
+#include "syntaxcheck.h"
+#include <QByteArray>
+#include <QString>
+#include <memory>
+
+// a snippet and the first diagnostic expected for it
+struct SyntaxCase
+{
+    const char *text;
+    // expected first diagnostic, if message is not null:
+    int line;       // 0-based
+    int start;
+    int length;
+    const char *message;
+};
+
+inline bool sameDiagnostics(const QVector<Diagnostic> &a, const QVector<Diagnostic> &b)
+{
+    if(a.size() != b.size()) return false;
+    for(int i = 0; i < a.size(); i++)
+        if(a[i].start != b[i].start || a[i].length != b[i].length || a[i].line != b[i].line || a[i].message != b[i].message)
+            return false;
+    return true;
+}
+
+// checks the first diagnostic of each case, and that checking the same
+// text again after an edit (the checkers are incremental) gives the same
+// results as the first time
+template<int N>
+void checkCases(const char *lang, const SyntaxCase (&cases)[N])
+{
+    for(const SyntaxCase &c : cases)
+    {
+        std::unique_ptr<SyntaxChecker> checker(SyntaxChecker::create(lang));
+        if(!CHECK_CTX(checker, lang)) return;
+        QVector<Diagnostic> d = checker->run(QByteArray(c.text));
+        checker->run(QByteArray(c.text) + "\n)");
+        CHECK_CTX(sameDiagnostics(checker->run(QByteArray(c.text)), d), c.text);
+        if(!c.message)
+        {
+            CHECK_CTX(d.isEmpty(), c.text);
+            continue;
+        }
+        if(!CHECK_CTX(!d.isEmpty(), c.text)) continue;
+        CHECK_CTX(d[0].severity == Diagnostic::Error, c.text);
+        CHECK_CTX(d[0].line == c.line, c.text);
+        CHECK_CTX(d[0].start == c.start, c.text);
+        CHECK_CTX(d[0].length == c.length, c.text);
+        CHECK_CTX(d[0].message == QString::fromUtf8(c.message), c.text);
+    }
+}
+
+#endif // SYNTAXCASES_H